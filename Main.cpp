@@ -3,83 +3,44 @@
 // #include "../raylib.h"
 // #include "../raymath.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <string>
 
 #include "entt.hpp"
+#include "asset_watcher.hpp"
+#include "components.hpp"
+#include "frame_pacer.hpp"
+#include "frame_stats.hpp"
+#include "game_constants.hpp"
+#include "game_registry.hpp"
+#include "game_systems.hpp"
+#include "ghost_race.hpp"
+#include "idle_detector.hpp"
+#include "input_recorder.hpp"
+#include "latency_tracker.hpp"
+#include "level.hpp"
+#include "memory_report.hpp"
+#include "profiler.hpp"
+#include "rewind_buffer.hpp"
+#include "system_scheduler.hpp"
+#include "world_snapshot.hpp"
 
 const int WINDOW_WIDTH = 1280;
 const int WINDOW_HEIGHT = 720;
-const float TARGET_FPS = 60;
-const float TIMESTEP = 1 / TARGET_FPS;
-
-// Game Constants
-const float gravity = 500.0f;
-const float drag = 1.0f;
-
-// Stats
-const float playerMoveSpeed = 20.0f;
-const float playerSlingPower = 10.0f;
-
-const float playerMaxHorizontalVelocity = 500.0f;
-const float playerMaxVerticalVelocity = 800.0f;
-
-const float playerAcceleration = 0.5f;
-const float playerDeceleration = 10.0f;
-
-const int numberOfPlatforms = 12;
-
-int death_counter = 0;
-int score = -1;
-float lineThickness = 0.0f;
-
-Vector2 initialSiopaoPos = {50,50};
-
-Vector2 staticPlatformPos[numberOfPlatforms] = {
-    {0,650}, // landing pad
-    {120,700},
-    {300,300},
-    {230,610},
-    {450,500},
-    {690,350},
-    {800,470},
-    {990,500},
-    {1000,360},
-    {730,150},
-    {880,200},
-    {1060,80}
-};
-
-// Loop Variables
-float accumulator = 0.0f;
-Vector2 playerForces;
-float frameTimer = 0.0f;
 
-// ECS structs
+// The level loaded when no --level is given
+const char* DEFAULT_LEVEL_PATH = "levels/level1.lvl";
 
-struct PositionComponent {
-    Vector2 position;
-};
-struct SizeComponent {
-    int width;
-    int height;
-};
-struct ColorComponent {
-    Color color;
-};
-struct VelocityComponent {
-    Vector2 velocity;
-    float speed;
-};
-struct CircleColliderComponent {
-    Vector2 center;
-    int radius;
-    bool onFloor;
-};
+// How often the F3 overlay's memory report is worked out again. Going over every
+// storage's entities takes as long as the level is big, so not every frame.
+const double MEMORY_REPORT_INTERVAL = 0.25;
 
-struct PointComponent
-{
-    bool point;
-};
+// Loop Variables
+float accumulator = 0.0f;
 
 ////////////////////////
 // UI structs and funcs
@@ -106,15 +67,20 @@ struct UIContainer : public UIComponent
 {
     std::vector<UIComponent*> children;
 
+    // Set when something in the UI changed since it was last drawn
+    bool dirty = true;
+
     // Adds a child to the container
     void AddChild(UIComponent* child)
     {
         children.push_back(child);
+        dirty = true;
     }
 
     // Adds a child to the container
     void RemoveChild(UIComponent* child)
     {
+        dirty = true;
         for(int i = 0; i < children.size(); i++) {
             if(children[i] == child) {
                 children.erase(children.begin()+i);
@@ -188,7 +154,10 @@ struct UILibrary
         // If the left mouse button was released, we handle the click from the root container
         if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
         {
-            root_container.HandleClick(GetMousePosition());
+            if (root_container.HandleClick(GetMousePosition()))
+            {
+                root_container.dirty = true;
+            }
         }
     }
 
@@ -231,334 +200,879 @@ struct Button : public UIComponent
     }
 };
 
+// Debug overlay (toggled with F3): a histogram of the recent frame times with
+// lines at the 50th, 99th and 99.9th percentiles, plus what the physics loop
+// and the UI are up to, and below it the memory each component storage takes.
+// Formats its text with TextFormat, so drawing it doesn't allocate.
+struct FrameStatsOverlay : public UIComponent
+{
+    FrameStats* stats = nullptr;
+    FramePacer* pacer = nullptr;
+    LatencyTracker* latency = nullptr;
+    // Only while racing
+    GhostRace* race = nullptr;
+    // The UI whose children are counted
+    UIContainer* ui = nullptr;
+    MemoryReport* memory = nullptr;
 
-Vector2 GetClosestPointAABBCircle(Vector2 sioPos, Vector2 rectPos, Vector2 rectSize) {
-    return {Clamp(sioPos.x, rectPos.x, rectPos.x + rectSize.x),
-            Clamp(sioPos.y, rectPos.y, rectPos.y + rectSize.y)};
-}
-
-
-int main() {
-    InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Siopao's First Stretch");
-    SetTargetFPS(TARGET_FPS);
-
-    UILibrary ui_library;
-    ui_library.root_container.bounds = { 10, 10, 600, 500 };
+    // Draw
+    void Draw() override
+    {
+        DrawRectangleRec(bounds, Fade(LIGHTGRAY, 0.85f));
+
+        float p50 = stats->GetPercentile(0.5f);
+        float p99 = stats->GetPercentile(0.99f);
+        float p999 = stats->GetPercentile(0.999f);
+
+        int x = bounds.x + 5;
+        int y = bounds.y + 5;
+        DrawText(TextFormat("Frame: %.2f ms (worst %.2f ms over %d frames)", stats->GetLatestMs(), stats->GetWorstMs(), int(stats->GetCount())), x, y, 10, BLACK);
+        DrawText(TextFormat("p50: %.2f ms  p99: %.2f ms  p99.9: %.2f ms", p50, p99, p999), x, y + 14, 10, BLACK);
+        DrawText(TextFormat("Physics steps: %d this frame (max %d)", stats->GetLatestSteps(), stats->GetMaxSteps()), x, y + 28, 10, BLACK);
+        DrawText(TextFormat("Accumulator backlog: %.2f ms", stats->GetBacklogMs()), x, y + 42, 10, BLACK);
+        DrawText(TextFormat("UI children: %d", int(ui->children.size())), x, y + 56, 10, BLACK);
+        DrawText(TextFormat("Pacing: late p50 %.3f p99 %.3f ms, jitter %.3f ms, missed %d", pacer->GetErrorPercentile(0.5f),
+                            pacer->GetErrorPercentile(0.99f), pacer->GetJitterMs(), int(pacer->GetMissedCount())), x, y + 70, 10, BLACK);
+        DrawText(TextFormat("Release to swap: p50 %.1f p99 %.1f ms (tick %.1f + swap %.1f)", latency->release_to_swap.GetPercentile(0.5f),
+                            latency->release_to_swap.GetPercentile(0.99f), latency->poll_to_tick.GetPercentile(0.5f),
+                            latency->tick_to_swap.GetPercentile(0.5f)), x, y + 84, 10, BLACK);
+        DrawText(TextFormat("Sling cursor age: p50 %.2f p99 %.2f ms", latency->cursor_age.GetPercentile(0.5f),
+                            latency->cursor_age.GetPercentile(0.99f)), x, y + 98, 10, BLACK);
+        if (race != nullptr) {
+            DrawText(TextFormat("Ghost: %d predicted ticks, %d rollbacks (worst %.2f ms)", int(race->GetPredictedTicks()),
+                                int(race->GetRollbackCount()), race->GetWorstRollbackMs()), x, y + 112, 10, BLACK);
+        }
 
-    Label death_count;
-    death_count.text = "Death Counter: " + std::to_string(death_counter);
-    death_count.bounds = { 10, 10, 80, 40 };
-    ui_library.root_container.AddChild(&death_count);
+        // Histogram along the bottom, one bar per bin, scaled to the fullest bin.
+        // Bins with any frames are at least a pixel high, so rare stalls still show up.
+        std::array<int, FRAME_HISTOGRAM_BINS> bins;
+        stats->GetHistogram(bins);
+        int most = std::max(1, *std::max_element(bins.begin(), bins.end()));
+
+        float graph_x = bounds.x + 5;
+        float graph_bottom = bounds.y + bounds.height - 5;
+        float graph_height = bounds.height - 141;
+        float bin_width = (bounds.width - 10) / FRAME_HISTOGRAM_BINS;
+
+        for (int i = 0; i < FRAME_HISTOGRAM_BINS; i++) {
+            if (bins[i] > 0) {
+                float height = std::max(1.0f, graph_height * bins[i] / most);
+                DrawRectangle(graph_x + i * bin_width, graph_bottom - height, std::max(1.0f, bin_width - 1), height, DARKGRAY);
+            }
+        }
 
-    Label score_text;
-    score_text.text = "Score: " + std::to_string(score);
-    score_text.bounds = { 150, 10, 80, 40 };
-    ui_library.root_container.AddChild(&score_text);
+        // Percentile lines, clamped to the last bin like the frames themselves
+        float percentiles[] = {p50, p99, p999};
+        Color colors[] = {GREEN, ORANGE, RED};
+        for (int i = 0; i < 3; i++) {
+            float bin = std::min(percentiles[i] / FRAME_HISTOGRAM_MS_PER_BIN, float(FRAME_HISTOGRAM_BINS));
+            int line_x = graph_x + bin * bin_width;
+            DrawLine(line_x, graph_bottom - graph_height, line_x, graph_bottom, colors[i]);
+        }
 
-    Label death_text;
-    death_text.text = "You died! Try again!";
-    death_text.bounds = { 10, 25, 80, 40 };
-    // ui_library.root_container.AddChild(&death_text);
+        // Memory table, one line per storage, under the frame times
+        int rows = int(memory->storages.size()) + 3;
+        int table_y = bounds.y + bounds.height + 5;
+        DrawRectangle(bounds.x, table_y, bounds.width, rows * 12 + 10, Fade(LIGHTGRAY, 0.85f));
+
+        y = table_y + 5;
+        DrawText("Storage              entities   used KB   reserved KB", x, y, 10, BLACK);
+        for (const StorageMemory& storage : memory->storages) {
+            y += 12;
+            // Type names aren't null terminated, so the length goes in the format
+            int name_length = std::min(int(storage.name.size()), 20);
+            DrawText(TextFormat("%-20.*s %8d %9.1f %13.1f%s", name_length, storage.name.data(), int(storage.entities),
+                                storage.GetUsed() / 1024.0f, storage.GetReserved() / 1024.0f, storage.known_size ? "" : " (?)"), x, y, 10, BLACK);
+        }
+        y += 12;
+        DrawText(TextFormat("%-20s %8d %9.1f %13.1f", "(entities)", int(memory->entities),
+                            memory->entities_used / 1024.0f, memory->entities_reserved / 1024.0f), x, y, 10, BLACK);
+        y += 12;
+        DrawText(TextFormat("Total %.1f KB used, %.1f KB reserved, arena %.1f KB", memory->GetUsed() / 1024.0f,
+                            memory->GetReserved() / 1024.0f, memory->arena_reserved / 1024.0f), x, y, 10, BLACK);
+    }
 
-    Label victory_text;
-    victory_text.text = "Yippee! Siopao made it to the steamer basket!";
-    victory_text.bounds = { 10, 100, 80, 40 };
-    // ui_library.root_container.AddChild(&victory_text);
+    // Handle mouse click
+    // Returns a boolean indicating whether this UI component successfully handled the event
+    bool HandleClick(Vector2 click_position) override
+    {
+        return false;
+    }
+};
 
-    entt::registry registry;
 
-    Texture2D siopao_texture = LoadTexture("assets/siopao spritesheet.png");
-    Rectangle frameRec;
-    frameRec.x = 0;
-    frameRec.y = 0;
-    frameRec.width = 64;
-    frameRec.height = 64;
+// What the HUD labels currently show
+struct HudState {
+    UIContainer* root = nullptr;
+    Label* death_count = nullptr;
+    Label* score_text = nullptr;
+    Label* death_text = nullptr;
+    Label* victory_text = nullptr;
 
-    Texture2D steamer_texture = LoadTexture("assets/steamer.png");
-    Rectangle frameRecSteamer;
-    frameRecSteamer.x = 0;
-    frameRecSteamer.y = 0;
-    frameRecSteamer.width = 64;
-    frameRecSteamer.height = 48;
-    Vector2 pos = {1080,40};
-    // Vector2 pos = {50,600};
+    int shown_score = -1;
+    int shown_deaths = 0;
+    bool shown_victory = false;
+};
 
+// Brings the UI up to date with what happened during the ticks.
+// Runs once per frame rather than per tick, and only touches the labels that changed.
+void HudSystem(const ScoreState& state, HudState& hud) {
+    if (hud.root == nullptr) {
+        return;
+    }
 
-    float frameSelector = 0;
+    if (state.score != hud.shown_score) {
+        hud.shown_score = state.score;
+        hud.score_text->text = "Score: " + std::to_string(hud.shown_score);
+        hud.root->dirty = true;
+    }
+    if (state.death_counter != hud.shown_deaths) {
+        if (hud.shown_deaths == 0) {
+            hud.root->AddChild(hud.death_text);
+        }
+        hud.shown_deaths = state.death_counter;
+        hud.death_count->text = "Death Counter: " + std::to_string(hud.shown_deaths);
+        hud.root->dirty = true;
+    }
+    if (state.won && !hud.shown_victory) {
+        hud.shown_victory = true;
+        hud.root->AddChild(hud.victory_text);
+    }
+}
 
-    //make siopao
-    entt::entity siopao = registry.create();
-    PositionComponent& pos_comp = registry.emplace<PositionComponent>(siopao);
-    VelocityComponent& vel_comp = registry.emplace<VelocityComponent>(siopao);
-    CircleColliderComponent& col_comp = registry.emplace<CircleColliderComponent>(siopao);
-    pos_comp.position = {50,50};
 
+// The first level as it was before levels came from files (levels/level1.txt is the same).
+// Used when the level file can't be loaded, so the game still starts.
+void CreateBuiltInLevel(GameRegistry& registry) {
+    LevelInfo info;
+    strcpy(info.name, "First_Stretch");
+
+    Vector2 positions[] = {
+        {0,650}, // landing pad
+        {120,700},
+        {300,300},
+        {230,610},
+        {450,500},
+        {690,350},
+        {800,470},
+        {990,500},
+        {1000,360},
+        {730,150},
+        {880,200},
+        {1060,80}
+    };
+    int numberOfPlatforms = sizeof(positions) / sizeof(positions[0]);
+
+    std::vector<LevelPlatform> platforms(numberOfPlatforms);
     for (int i = 0; i < numberOfPlatforms; i++) {
-        entt::entity platform = registry.create();
-        PositionComponent& pos_comp = registry.emplace<PositionComponent>(platform);
-        ColorComponent& color_comp = registry.emplace<ColorComponent>(platform);
-        SizeComponent& size_comp = registry.emplace<SizeComponent>(platform);
-        PointComponent& point_comp = registry.emplace<PointComponent>(platform);
-        point_comp.point = false;
-        pos_comp.position.x = staticPlatformPos[i].x;
-        pos_comp.position.y = staticPlatformPos[i].y;
-        color_comp.color = DARKBLUE;
+        platforms[i].x = positions[i].x;
+        platforms[i].y = positions[i].y;
         // pseudo random width for difficulty
         if (i == 0) {
-            size_comp.width = 150;
+            platforms[i].width = 150;
         }
         else if (i % 2 == 0 && i != 0) {
-            size_comp.width = 100/(i/2) + (i*20) - 20;
+            platforms[i].width = 100/(i/2) + (i*20) - 20;
         } else if (i % 2 != 0 && i != numberOfPlatforms-1) {
-            size_comp.width = i*30 - 30;
+            platforms[i].width = i*30 - 30;
         } else {
-            size_comp.width = 100;
+            platforms[i].width = 100;
         }
-        size_comp.height = 25;
+        platforms[i].height = 25;
     }
 
+    CreateLevelEntities(registry, info, platforms);
+}
 
-    while (!WindowShouldClose()) {
+// The sling line, from the middle of Siopao to the mouse
+void DrawSlingLine(const PositionComponent& position, const AnimationComponent& animation, const SlingComponent& sling, Vector2 mouse_position) {
+    DrawLineEx({position.position.x+(animation.frameRec.width/2), position.position.y+(animation.frameRec.height/2)},mouse_position,1.0f+sling.lineThickness,RED);
+}
 
-        ui_library.Update();
-        
-        // Physics Loop
-        float delta_time = GetFrameTime();
-        accumulator += delta_time;
+// One fixed timestep of the game: rewinds while R is held, runs the tick systems otherwise
+void GameTick(GameRegistry& registry, SystemScheduler& tick_systems, const TickInput& input, RewindBuffer& rewind_buffer, const WorldSnapshot& level_start) {
+    PROFILE_SCOPE("Tick");
+    ScoreState& state = registry.ctx().get<ScoreState>();
 
-        //declate what we call for siopao
-        auto Siopao = registry.view<PositionComponent, VelocityComponent>();
-        auto Platform = registry.view<PositionComponent, ColorComponent, SizeComponent>();
+    if (input.rewind) {
+        PROFILE_SCOPE("Rewind");
+        if (rewind_buffer.CanRewind()) {
+            rewind_buffer.RewindTo(registry, rewind_buffer.GetNewestTick() - 1);
+            state.score = CountScore(registry);
+        }
+        return;
+    }
 
-        while (accumulator >= TIMESTEP) {
+    registry.ctx().get<TickInput>() = input;
+    tick_systems.Run(registry);
 
-            // do stuff aka physics
-            for (auto entity: Siopao) {
-                PositionComponent& position = registry.get<PositionComponent>(entity);
-                VelocityComponent& velocity = registry.get<VelocityComponent>(entity);
-                CircleColliderComponent& collider = registry.get<CircleColliderComponent>(entity);
+    // Respawning restores the whole world to how it was at the start,
+    // platform points included
+    if (state.respawn) {
+        PROFILE_SCOPE("Respawn");
+        LoadWorld(registry, level_start);
+        state.respawn = false;
+    }
 
-                // Player Info
-                float playerBottomBound = position.position.y + frameRec.height;
-                float playerLeftBound = position.position.x;
-                float playerRightBound = position.position.x + frameRec.width;
-                Vector2 playerCenterPos = {position.position.x + frameRec.width/2, position.position.y + frameRec.height/2};
+    PROFILE_SCOPE("Record rewind");
+    rewind_buffer.Record(registry);
+}
 
-                collider.onFloor = false;
+// Writes what the profiler recorded to the file given with --trace, if any
+void SaveTrace(const std::string& path) {
+    if (path.empty()) {
+        return;
+    }
 
-                // Totaling every force done on the player at a given frame
-                playerForces = {0, 0};
+    if (WriteChromeTrace(path)) {
+        std::cout << "Wrote trace to " << path << " (open it in chrome://tracing or ui.perfetto.dev)" << std::endl;
+    }
+    else {
+#ifdef SIOPAO_PROFILE
+        std::cout << "Could not save " << path << std::endl;
+#else
+        std::cout << "No trace saved, the game has to be built with -DSIOPAO_PROFILE for --trace" << std::endl;
+#endif
+    }
+}
 
-                if (frameTimer > 0.2f) {
-                    frameSelector += 1;
-                    if (frameSelector > 2) {
-                        frameSelector = 0;
-                    }
-                    frameTimer = 0.0f;
-                }
+// Plays a recording back without a window, as fast as possible.
+// Prints the tick rate (to compare builds) and a checksum of Siopao's position
+// on every tick (to check that replays reproduce the session bit for bit).
+int RunHeadlessReplay(InputRecording& recording, GameRegistry& registry, SystemScheduler& tick_systems, RewindBuffer& rewind_buffer, const WorldSnapshot& level_start) {
+    auto Siopao = registry.view<PositionComponent, VelocityComponent>();
 
-                if (abs(vel_comp.velocity.x) < 0.1f &&
-                    abs(vel_comp.velocity.y) < 0.1f) {
-                    frameRec.x = (64*frameSelector);
-                }
+    uint64_t ticks = 0;
+    uint64_t checksum = 14695981039346656037ull;
+    TickInput input;
 
-                //For each platform
-                for(auto entity: Platform)
-                {
-                    PositionComponent& rect_pos_comp = registry.get<PositionComponent>(entity);
-                    SizeComponent& rect_size_comp = registry.get<SizeComponent>(entity);
-                    PointComponent& rect_point_comp = registry.get<PointComponent>(entity);
-
-                    //Clamp siopao to the platform
-                    Vector2 closestPoint = GetClosestPointAABBCircle(Vector2Add(position.position, {frameRec.width/2,frameRec.height/2}), rect_pos_comp.position, {float (rect_size_comp.width), float (rect_size_comp.height)});
-                    
-                    float platformLeftBound = rect_pos_comp.position.x;
-                    float platformRightBound = rect_pos_comp.position.x + rect_size_comp.width;
-                    float platformUpperBound = rect_pos_comp.position.y;
-                    Vector2 platformCenterPos = {rect_pos_comp.position.x + rect_size_comp.width/2, rect_pos_comp.position.y + rect_size_comp.height/2};
-
-                    //if siopao is touching it
-                    if (Vector2Distance(Vector2Add(position.position, {frameRec.width/2,frameRec.height/2}), closestPoint) <= frameRec.width/2) {
-                        //do stuff  
-                        if (playerBottomBound <= platformUpperBound + rect_size_comp.height/2) {
-                            //position.position.y = rect_pos_comp.position.y - frameRec.height;
-                            collider.onFloor = true;
-                            if(!rect_point_comp.point)
-                            {
-                                rect_point_comp.point = true;
-                                score += 1;
-                                score_text.text = "Score: " + std::to_string(score);
-
-                            }
-                        }
-                        else {
-                            if (playerLeftBound > platformLeftBound && 
-                                velocity.velocity.x < 0.0f) {
-
-                                velocity.velocity.x = 5.0f;
-                            }
-                            if (playerRightBound < platformRightBound && 
-                                velocity.velocity.x > 0.0f) {
-
-                                velocity.velocity.x = -5.0f;
-                            }
-                        }
-                    }
+    std::cout << "Systems:" << std::endl;
+    tick_systems.PrintGraph(std::cout);
 
-                }
+    auto start = std::chrono::steady_clock::now();
 
-                if((Vector2Distance(Vector2Add(position.position, {frameRec.width/2,frameRec.height/2}), Vector2Add(pos, {frameRecSteamer.width/2,frameRecSteamer.height/2})) <= frameRec.width/2)) {
-                    score = 1000;
-                    score_text.text = "Score: " + std::to_string(score);
-                    ui_library.root_container.AddChild(&victory_text);
-                }                    
-
-                // Reaching Bottom Edge of Screen
-                if (position.position.y + frameRec.height >= WINDOW_HEIGHT) {
-                    position.position.y = WINDOW_HEIGHT - frameRec.height;
-                    col_comp.onFloor = true;
-                    ui_library.root_container.AddChild(&death_text);
-                    position.position = initialSiopaoPos;
-                    death_counter = death_counter + 1;
-                    death_count.text = "Death Counter: " + std::to_string(death_counter);
-
-                    score = -1;
-                    score_text.text = "Score: " + std::to_string(score);
-                }
-                else {
-                    //col_comp.onFloor = false;
-                }
-                if (position.position.y <= 0) {
-                    if (vel_comp.velocity.y != 0.0f) {
-                        vel_comp.velocity.y = 0.0f;   
-                    }  
-                    position.position.y = 0;
-                }
+    while (recording.Next(input)) {
+        GameTick(registry, tick_systems, input, rewind_buffer, level_start);
+        ticks++;
 
-                // Reaching Right Corner of Screen
-                if (position.position.x + frameRec.width >= WINDOW_WIDTH) {
-                    if (vel_comp.velocity.x > 0.0f) {
-                        vel_comp.velocity.x = 0.0f;   
-                    }  
-                    position.position.x = WINDOW_WIDTH - frameRec.width;
-                }
+        // FNV-1a over the raw bytes of the position
+        for (auto entity: Siopao) {
+            unsigned char bytes[sizeof(Vector2)];
+            memcpy(bytes, &registry.get<PositionComponent>(entity).position, sizeof(Vector2));
+            for (unsigned char byte : bytes) {
+                checksum = (checksum ^ byte) * 1099511628211ull;
+            }
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Ticks: " << ticks << std::endl;
+    std::cout << "Time: " << seconds << " s (" << (seconds > 0.0 ? ticks / seconds : 0.0) << " ticks/sec)" << std::endl;
+    std::cout << "Position checksum: " << std::hex << checksum << std::dec << std::endl;
+    if (Siopao.front() != entt::null) {
+        Vector2 position = registry.get<PositionComponent>(Siopao.front()).position;
+        std::cout << "Final position: " << std::hexfloat << position.x << ", " << position.y << std::defaultfloat << std::endl;
+    }
+    const ScoreState& state = registry.ctx().get<ScoreState>();
+    std::cout << "Score: " << state.score << ", Deaths: " << state.death_counter << std::endl;
+
+    MemoryReport memory;
+    UpdateMemoryReport(registry, memory);
+    std::cout << "Memory:" << std::endl;
+    PrintMemoryReport(memory, std::cout);
+
+    return 0;
+}
+
+// Hash of where Siopao is and how he's doing, to compare the end of a race between two games
+uint64_t GetSiopaoChecksum(const GameRegistry& registry) {
+    uint64_t checksum = 14695981039346656037ull;
+    auto add = [&checksum](const auto& value) {
+        unsigned char bytes[sizeof(value)];
+        memcpy(bytes, &value, sizeof(value));
+        for (unsigned char byte : bytes) {
+            checksum = (checksum ^ byte) * 1099511628211ull;
+        }
+    };
+
+    for (auto [entity, position, velocity] : registry.view<const PositionComponent, const VelocityComponent>().each()) {
+        add(position.position);
+        add(velocity.velocity);
+    }
+    add(registry.ctx().get<ScoreState>().score);
+    add(registry.ctx().get<ScoreState>().death_counter);
+    return checksum;
+}
+
+// Plays a recording back against another game doing the same (--race), without a
+// window but in real time, so the network delay means something. Once both are
+// done, prints both Siopaos' checksums: this game's ghost has to end up exactly
+// where the other game's own Siopao did, however many rollbacks it took.
+int RunHeadlessRace(InputRecording& recording, GameRegistry& registry, SystemScheduler& tick_systems, RewindBuffer& rewind_buffer,
+                    const WorldSnapshot& level_start, GhostRace& race) {
+    FramePacer pacer(TARGET_FPS);
+    TickInput input;
+    uint64_t ticks = 0;
+    bool finished = false;
+
+    // They may have everything and be gone before their last acknowledgement
+    // gets here, so once we have all of theirs, we only wait so long for it
+    int linger_frames = 0;
+    bool warned_peer_gone = false;
+
+    std::cout << "Waiting for the other game..." << std::endl;
+
+    while (!race.IsComplete() && linger_frames < 2 * TARGET_FPS) {
+        if (!finished && race.CanAdvance()) {
+            if (recording.Next(input)) {
+                input.rewind = false;
+                GameTick(registry, tick_systems, input, rewind_buffer, level_start);
+                race.AddLocalInput(input);
+                ticks++;
+            }
+            else {
+                finished = true;
+                race.Finish();
+            }
+        }
 
-                // Reaching Left Corner of Screen
-                if (position.position.x <= 0) {
-                    if (vel_comp.velocity.x < 0.0f) {
-                        vel_comp.velocity.x = 0.0f;   
-                    }  
-                    position.position.x = 0.0f;
+        race.Exchange();
+        race.Simulate(GameTick);
+
+        if (race.IsWrongLevel()) {
+            std::cout << "The other game is playing a different level" << std::endl;
+            return 1;
+        }
+        if (race.IsPeerGone() && !warned_peer_gone) {
+            std::cout << "The other game stopped answering, carrying on alone" << std::endl;
+            warned_peer_gone = true;
+        }
+        if (finished && race.HasAllRemoteInput()) {
+            linger_frames++;
+        }
+
+        // Nothing to show, so no need to spin for an exact frame time
+        pacer.Skip();
+    }
+
+    std::cout << "Ticks: " << ticks << " (ghost " << race.GetGhostTick() << ")" << std::endl;
+    std::cout << "Siopao checksum: " << std::hex << GetSiopaoChecksum(registry) << std::dec << std::endl;
+    std::cout << "Ghost checksum: " << std::hex << GetSiopaoChecksum(race.GetGhost()) << std::dec << std::endl;
+    race.Print(std::cout);
+    return 0;
+}
+
+// Command line options:
+//   --record <file>   saves every tick's input to the file when the game is closed
+//   --replay <file>   plays a recording back instead of reading the keyboard and mouse
+//   --headless        with --replay, runs it as fast as possible without a window
+//   --level <file>    plays a level made with level_converter (default levels/level1.lvl)
+//   --serial          runs the systems one after another on the main thread
+//   --bodies <n>      adds more Siopaos (all driven by the same input, only yours scores or restarts the level), for stress tests
+//   --trace <file>    saves how long each frame, tick and system took as a Chrome trace
+//                     when the game closes (needs a build with -DSIOPAO_PROFILE)
+//   --vsync           shows frames at the display's refresh rate instead of pacing them to 60 FPS
+//   --always-draw     draws every frame, even the ones that look the same as the last one
+//   --late-latch      draws the sling line last, with the cursor read right before the swap
+//                     (needs a build with -DSIOPAO_LATE_LATCH)
+//   --race <port> <other port>
+//                     races another copy of the game on this machine, listening on 127.0.0.1:port
+//                     for the one listening on the other port; each sees the other's Siopao as a ghost
+//   --net-delay <ms>  with --race, holds every packet back this long, like a slow network would
+//   --net-loss <%>    with --race, drops this percentage of packets
+int main(int argc, char** argv) {
+    std::string level_path = DEFAULT_LEVEL_PATH;
+    std::string record_path;
+    std::string replay_path;
+    std::string trace_path;
+    bool headless = false;
+    bool serial = false;
+    bool vsync = false;
+    bool always_draw = false;
+    bool late_latch = false;
+    int race_port = 0;
+    int race_other_port = 0;
+    NetConditions net_conditions;
+    int body_count = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        }
+        else if (arg == "--headless") {
+            headless = true;
+        }
+        else if (arg == "--level" && i + 1 < argc) {
+            level_path = argv[++i];
+        }
+        else if (arg == "--serial") {
+            serial = true;
+        }
+        else if (arg == "--bodies" && i + 1 < argc) {
+            body_count = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        }
+        else if (arg == "--vsync") {
+            vsync = true;
+        }
+        else if (arg == "--always-draw") {
+            always_draw = true;
+        }
+        else if (arg == "--late-latch") {
+            late_latch = true;
+        }
+        else if (arg == "--race" && i + 2 < argc) {
+            race_port = std::stoi(argv[++i]);
+            race_other_port = std::stoi(argv[++i]);
+        }
+        else if (arg == "--net-delay" && i + 1 < argc) {
+            net_conditions.delay_ms = std::max(0.0f, std::stof(argv[++i]));
+        }
+        else if (arg == "--net-loss" && i + 1 < argc) {
+            net_conditions.loss = std::clamp(std::stof(argv[++i]) / 100.0f, 0.0f, 1.0f);
+        }
+        else {
+            std::cout << "Usage: " << argv[0] << " [--level <file>] [--record <file>] [--replay <file> [--headless]] [--serial] [--bodies <n>] [--trace <file>] [--vsync] [--always-draw] [--late-latch] [--race <port> <other port> [--net-delay <ms>] [--net-loss <%>]]" << std::endl;
+            return 1;
+        }
+    }
+
+    PROFILE_THREAD_NAME("Main");
+
+    if (late_latch && !CanLateLatch()) {
+        std::cout << "No late latching, the game has to be built with -DSIOPAO_LATE_LATCH for --late-latch" << std::endl;
+        late_latch = false;
+    }
+
+    bool replaying = !replay_path.empty();
+    bool recording_input = !record_path.empty();
+
+    InputRecording recording;
+    if (replaying && !recording.Load(replay_path)) {
+        std::cout << "Could not load " << replay_path << std::endl;
+        return 1;
+    }
+
+    // The level's storages all live in its own arena (see game_registry.hpp)
+    std::unique_ptr<LevelWorld> level = std::make_unique<LevelWorld>();
+    if (!LoadLevel(level->registry, level_path)) {
+        std::cout << "Could not load " << level_path << ", using the built-in level" << std::endl;
+        // Throws away whatever the failed load made, all at once
+        level = std::make_unique<LevelWorld>();
+        CreateBuiltInLevel(level->registry);
+    }
+    GameRegistry& registry = level->registry;
+
+    // The extra bodies start spread out to the right of the spawn point
+    LevelInfo crowd_spawn = registry.ctx().get<LevelInfo>();
+    for (int i = 1; i < body_count; i++) {
+        crowd_spawn.spawn.x = registry.ctx().get<LevelInfo>().spawn.x + float(i % 64) * 2;
+        CreateSiopao(registry, crowd_spawn);
+    }
+
+    // Platforms close together in the level go close together in memory
+    SortPlatforms(registry);
+
+    CreateGameState(registry);
+
+    // Systems run as jobs on every core (the main thread helps while it waits for them)
+    SystemScheduler tick_systems(serial ? nullptr : JobSystem::GetInstance());
+    AddTickSystems(tick_systems);
+    tick_systems.Build(registry);
+
+    WorldSnapshot level_start;
+    SaveWorld(registry, level_start);
+
+    // Everything the level needs is allocated by now; whatever grows later goes to the heap
+    level->arena.Seal();
+
+    // Holding R rewinds through the last 10 seconds, one tick per tick
+    RewindBuffer rewind_buffer(uint32_t(10 * TARGET_FPS), 30);
+
+    std::unique_ptr<GhostRace> race;
+    if (race_port != 0) {
+        race = std::make_unique<GhostRace>(registry, level_start);
+        if (!race->Connect(uint16_t(race_port), uint16_t(race_other_port), net_conditions)) {
+            std::cout << "Could not listen on port " << race_port << std::endl;
+            return 1;
+        }
+    }
+
+    if (headless) {
+        if (!replaying) {
+            std::cout << "--headless needs a recording to --replay" << std::endl;
+            return 1;
+        }
+
+        if (race) {
+            int result = RunHeadlessRace(recording, registry, tick_systems, rewind_buffer, level_start, *race);
+            SaveTrace(trace_path);
+            return result;
+        }
+
+        int result = RunHeadlessReplay(recording, registry, tick_systems, rewind_buffer, level_start);
+        SaveTrace(trace_path);
+        return result;
+    }
+
+    if (vsync) {
+        SetConfigFlags(FLAG_VSYNC_HINT);
+    }
+    InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Siopao's First Stretch");
+
+    // Frames are paced by the pacer instead of SetTargetFPS (see frame_pacer.hpp)
+    FramePacer frame_pacer(TARGET_FPS);
+    if (vsync) {
+        frame_pacer.SyncToDisplay(GetMonitorRefreshRate(GetCurrentMonitor()));
+    }
+
+    UILibrary ui_library;
+    ui_library.root_container.bounds = { 10, 10, 600, 500 };
+
+    Label death_count;
+    death_count.text = "Death Counter: " + std::to_string(registry.ctx().get<ScoreState>().death_counter);
+    death_count.bounds = { 10, 10, 80, 40 };
+    ui_library.root_container.AddChild(&death_count);
+
+    Label score_text;
+    score_text.text = "Score: " + std::to_string(registry.ctx().get<ScoreState>().score);
+    score_text.bounds = { 150, 10, 80, 40 };
+    ui_library.root_container.AddChild(&score_text);
+
+    Label death_text;
+    death_text.text = "You died! Try again!";
+    death_text.bounds = { 10, 25, 80, 40 };
+    // ui_library.root_container.AddChild(&death_text);
+
+    Label victory_text;
+    victory_text.text = "Yippee! Siopao made it to the steamer basket!";
+    victory_text.bounds = { 10, 100, 80, 40 };
+    // ui_library.root_container.AddChild(&victory_text);
+
+    Label waiting_text;
+    waiting_text.text = "Waiting for the other player...";
+    waiting_text.bounds = { 10, 40, 80, 40 };
+    bool waiting_for_race = race != nullptr;
+    if (waiting_for_race) {
+        ui_library.root_container.AddChild(&waiting_text);
+    }
+    bool warned_wrong_level = false;
+    bool warned_peer_gone = false;
+
+    HudState hud;
+    hud.root = &ui_library.root_container;
+    hud.death_count = &death_count;
+    hud.score_text = &score_text;
+    hud.death_text = &death_text;
+    hud.victory_text = &victory_text;
+    hud.shown_score = registry.ctx().get<ScoreState>().score;
+    hud.shown_deaths = registry.ctx().get<ScoreState>().death_counter;
+    registry.ctx().insert_or_assign(hud);
+
+    FrameStats frame_stats;
+    LatencyTracker latency;
+    MemoryReport memory_report;
+    double memory_report_time = 0.0;
+    FrameStatsOverlay frame_stats_overlay;
+    frame_stats_overlay.stats = &frame_stats;
+    frame_stats_overlay.pacer = &frame_pacer;
+    frame_stats_overlay.latency = &latency;
+    frame_stats_overlay.race = race.get();
+    frame_stats_overlay.ui = &ui_library.root_container;
+    frame_stats_overlay.memory = &memory_report;
+    frame_stats_overlay.bounds = { WINDOW_WIDTH - 370, 10, 360, 236 };
+    bool show_frame_stats = false;
+
+    // Per-frame systems; they touch the UI, so they stay on the main thread
+    SystemScheduler frame_systems(nullptr);
+    frame_systems.Add<&HudSystem>("hud");
+    frame_systems.Build(registry);
+
+    // Use the pre-decoded asset pack when there is one (see asset_packer.cpp),
+    // otherwise the textures are decoded from the PNGs
+    ResourceManager::GetInstance()->MountAssetPack("assets/assets.pack");
+
+    // Textures go through the resource manager so the asset watcher can hot-reload them
+    using namespace entt::literals;
+    TextureHandle siopao_texture = ResourceManager::GetInstance()->GetTexture("assets/siopao spritesheet.png"_hs);
+    TextureHandle steamer_texture = ResourceManager::GetInstance()->GetTexture("assets/steamer.png"_hs);
+
+    AssetWatcher asset_watcher("assets");
+
+    // Quick save (F5) and quick load (F9), also kept on disk between runs.
+    // Not available while recording or replaying, since it isn't part of the recorded input.
+    WorldSnapshot quick_save;
+
+    // Input of the latest tick
+    TickInput input;
+    bool replay_finished = false;
+
+    auto Siopao = registry.view<PositionComponent, AnimationComponent, SlingComponent>();
+    auto Platform = registry.view<PositionComponent, ColorComponent, SizeComponent>();
+    std::vector<entt::entity> visible_platforms;
+
+    // Frames that would look like the one on screen aren't drawn (see idle_detector.hpp).
+    // Since skipped frames don't go through EndDrawing, frame times come from the clock
+    // rather than GetFrameTime.
+    IdleDetector idle;
+    double last_frame_time = GetTime();
+
+    while (!WindowShouldClose()) {
+        PROFILE_SCOPE("Frame");
+
+        {
+            PROFILE_SCOPE("UI update");
+            ui_library.Update();
+        }
+
+        if (IsKeyPressed(KEY_F3)) {
+            show_frame_stats = !show_frame_stats;
+            if (show_frame_stats) {
+                ui_library.root_container.AddChild(&frame_stats_overlay);
+                // Up to date right away, not only after the first interval
+                memory_report_time = GetTime() - MEMORY_REPORT_INTERVAL;
+            }
+            else {
+                ui_library.root_container.RemoveChild(&frame_stats_overlay);
+            }
+        }
+
+        if (!replaying && !recording_input) {
+            if (IsKeyPressed(KEY_F5)) {
+                SaveWorld(registry, quick_save);
+                SaveWorldToFile(quick_save, "quicksave.bin");
+            }
+            if (IsKeyPressed(KEY_F9) && (!quick_save.data.empty() || LoadWorldFromFile(quick_save, "quicksave.bin"))) {
+                LoadWorld(registry, quick_save);
+                registry.ctx().get<ScoreState>().score = CountScore(registry);
+            }
+        }
+        
+        // Physics Loop
+        double frame_time = GetTime();
+        float delta_time = float(frame_time - last_frame_time);
+        last_frame_time = frame_time;
+        accumulator += delta_time;
+        int physics_steps = 0;
+
+        {
+            PROFILE_SCOPE("Physics");
+            while (accumulator >= TIMESTEP) {
+                // Too far ahead of the other player: wait for them, without catching up on the time afterwards
+                if (race && !race->CanAdvance()) {
+                    accumulator = 0.0f;
+                    break;
                 }
 
-                if (col_comp.onFloor) {
-                    //Basic Movement
-                    if(IsKeyDown(KEY_A)) {
-                        frameRec.x = (64*4);
-                        //vel_comp.velocity = {-50,0};
-                        playerForces = Vector2Add(playerForces, {-playerMoveSpeed, 0});
-                        // vel_comp.speed = 1.5f;
-                    }
-                    if(IsKeyDown(KEY_D)) {
-                        frameRec.x = (64*3);
-                        //vel_comp.velocity = {50,0};
-                        playerForces = Vector2Add(playerForces, {playerMoveSpeed, 0});
-                        // vel_comp.speed = 1.5f;
+                if (replaying) {
+                    if (!replay_finished && !recording.Next(input)) {
+                        std::cout << "Replay finished" << std::endl;
+                        replay_finished = true;
                     }
-                    
-                    // Sling Mechanic
-                    Vector2 initialMousePos;
-                    Vector2 currentMousePos;
-                    float force;
-                    if (IsMouseButtonPressed(0)) {
-                        initialMousePos = Vector2(GetMousePosition());
-                        force = 0.0f;
+                    if (replay_finished) {
+                        input = TickInput();
                     }
-                    if (initialMousePos.x != NULL && initialMousePos.y != NULL) {
-                        while (IsMouseButtonDown(0)) {
-                            currentMousePos = GetMousePosition();
-                            force += TIMESTEP;
-                            lineThickness += TIMESTEP;
-
-                            frameSelector = 2;
-                            
-                            frameRec.x = (64*frameSelector);
-
-                            break;
-                        }
+                }
+                else {
+                    input = SampleTickInput();
+                    // The other game can't rewind our Siopao, so nobody rewinds while racing
+                    if (race) {
+                        input.rewind = false;
                     }
-                    if (IsMouseButtonReleased(0)) {
-                        playerForces = Vector2Add(playerForces,Vector2Scale(Vector2Negate(Vector2Subtract(currentMousePos, initialMousePos)),Clamp(force,0.0f,5.0f) * 2.0f));
-                        lineThickness = 0.0f;
+                    if (recording_input) {
+                        recording.Append(input);
                     }
                 }
 
-                // Apply Player Forces
-                vel_comp.velocity = Vector2Add(vel_comp.velocity, playerForces);
+                GameTick(registry, tick_systems, input, rewind_buffer, level_start);
+                if (!replaying && input.sling_released) {
+                    latency.ReleaseTicked();
+                }
+                if (race) {
+                    race->AddLocalInput(input);
+                }
 
-                if (!col_comp.onFloor) {
-                    // Gravity
-                    vel_comp.velocity = Vector2Add(vel_comp.velocity, {0.0f, gravity * TIMESTEP * 2});
-                    vel_comp.velocity = Vector2Subtract(vel_comp.velocity, {vel_comp.velocity.x * drag * TIMESTEP * 2, 0.0f});
+                accumulator -= TIMESTEP;
+                physics_steps++;
+            }
+        }
 
-                    if (vel_comp.velocity.x < 0.0f) {
-                        frameSelector = 4;
-                        frameRec.x = (64*frameSelector);
-                    }
-                    if (vel_comp.velocity.x > 0.0f) {
-                        frameSelector = 3;
-                        frameRec.x = (64*frameSelector);
-                    }
+        // Trade input with the other game and bring their ghost up to date
+        if (race) {
+            PROFILE_SCOPE("Ghost race");
+            race->Exchange();
+            race->Simulate(GameTick);
+
+            // Shown until the other game turns up, and again whenever it keeps us waiting
+            if (waiting_for_race != race->IsWaiting()) {
+                waiting_for_race = !waiting_for_race;
+                if (waiting_for_race) {
+                    ui_library.root_container.AddChild(&waiting_text);
                 }
                 else {
-                    // Stop on platform
-                    if (vel_comp.velocity.y > 0.0f) {
-                        vel_comp.velocity.y = 0.0f;   
-                    } 
-                    
-                    if (vel_comp.velocity.y == 0.0f) {
-                        // Deceleration Horizontal
-                        vel_comp.velocity = Vector2Subtract(vel_comp.velocity, {vel_comp.velocity.x * playerDeceleration * TIMESTEP, 0.0f});
-                    }
+                    ui_library.root_container.RemoveChild(&waiting_text);
                 }
+            }
+            if (race->IsPeerGone() && !warned_peer_gone) {
+                std::cout << "The other game stopped answering, carrying on alone" << std::endl;
+                warned_peer_gone = true;
+            }
+            if (race->IsWrongLevel() && !warned_wrong_level) {
+                std::cout << "The other game is playing a different level" << std::endl;
+                warned_wrong_level = true;
+            }
+        }
 
-                // Keep within Max Velocity
-                vel_comp.velocity = {Clamp(vel_comp.velocity.x, -playerMaxHorizontalVelocity, playerMaxHorizontalVelocity), 
-                                     Clamp(vel_comp.velocity.y, -playerMaxVerticalVelocity, playerMaxVerticalVelocity)};
+        frame_stats.Add(delta_time * 1000.0f, physics_steps, accumulator * 1000.0f);
+        if (show_frame_stats && GetTime() - memory_report_time >= MEMORY_REPORT_INTERVAL) {
+            UpdateMemoryReport(registry, memory_report);
+            memory_report_time = GetTime();
+        }
 
+        // Bring the UI up to date with what happened during the ticks
+        frame_systems.Run(registry);
 
-                frameTimer += TIMESTEP;
+        // Swap in any textures the asset watcher reloaded, before anything is drawn
+        bool textures_changed = false;
+        {
+            PROFILE_SCOPE("Upload textures");
+            textures_changed = ResourceManager::GetInstance()->UploadPendingTextures();
+        }
 
-                //just add velocity to position per timestep
-                position.position = Vector2Add(position.position, Vector2Scale(velocity.velocity, TIMESTEP));
+        // The sling line follows the live mouse, or the recorded one during a replay
+        bool sling_down = replaying ? input.sling_down : IsMouseButtonDown(0);
+        Vector2 mouse_position = replaying ? input.mouse_position : GetMousePosition();
+
+        // Only the platforms on screen are drawn. The grid is brought up to date first,
+        // in case a quick load changed the platforms since the last tick.
+        PlatformGrid& platform_grid = registry.ctx().get<PlatformGrid>();
+        platform_grid.Update(Platform);
+        platform_grid.Query({0, 0, float(WINDOW_WIDTH), float(WINDOW_HEIGHT)}, Platform, visible_platforms);
+
+        // Everything drawn below goes into the frame's hash
+        idle.Begin();
+        idle.Add(registry.ctx().get<LevelInfo>().goal);
+        idle.Add(sling_down);
+        if (sling_down) {
+            idle.Add(mouse_position);
+        }
+        for (auto [entity, position, animation, sling] : Siopao.each()) {
+            idle.Add(position);
+            idle.Add(animation.frameRec);
+            if (sling_down) {
+                idle.Add(sling.lineThickness);
             }
+        }
+        if (race) {
+            for (auto [entity, position, animation] : race->GetGhost().view<const PositionComponent, const AnimationComponent>().each()) {
+                idle.Add(position);
+                idle.Add(animation.frameRec);
+            }
+        }
+        for (auto entity: visible_platforms) {
+            idle.Add(registry.get<PositionComponent>(entity));
+            idle.Add(registry.get<SizeComponent>(entity));
+            idle.Add(registry.get<ColorComponent>(entity));
+        }
 
-            accumulator -= TIMESTEP;
+        // Called every frame, not only when nothing before it in the || forces a draw,
+        // so it doesn't miss any changes
+        bool window_changed = idle.WindowChanged();
+        // The overlay changes every frame, so it's always drawn while it's up
+        bool force_draw = always_draw || show_frame_stats || textures_changed || ui_library.root_container.dirty ||
+                          window_changed || HasInput();
+        if (!idle.NeedsDrawing(force_draw)) {
+            PROFILE_SCOPE("Idle");
+            frame_pacer.Skip();
+            // Without EndDrawing, raylib doesn't poll the input either
+            PollInputEvents();
+            latency.InputPolled();
+            continue;
         }
-       
+        ui_library.root_container.dirty = false;
 
-        BeginDrawing();
-        ClearBackground(WHITE);
-        DrawTextureRec(steamer_texture, frameRecSteamer, pos, WHITE);
-        //based on position draw siopao
-        for (auto entity: Siopao) {
-            PositionComponent& position = registry.get<PositionComponent>(entity);
-            DrawTextureRec(siopao_texture, frameRec, position.position, WHITE);
-            if (IsMouseButtonDown(0)) {
-                DrawLineEx({position.position.x+(frameRec.width/2), position.position.y+(frameRec.height/2)},GetMousePosition(),1.0f+lineThickness,RED);
+        // With late latching, the live sling line is left out here and drawn last
+        bool late_latch_line = late_latch && sling_down && !replaying;
+
+        {
+            PROFILE_SCOPE("Draw");
+            BeginDrawing();
+            ClearBackground(WHITE);
+            DrawTextureRec(steamer_texture.Get(), frameRecSteamer, registry.ctx().get<LevelInfo>().goal, WHITE);
+            // The other player's Siopao, see-through and under ours
+            if (race) {
+                for (auto [entity, position, animation] : race->GetGhost().view<const PositionComponent, const AnimationComponent>().each()) {
+                    DrawTextureRec(siopao_texture.Get(), animation.frameRec, position.position, Fade(WHITE, 0.4f));
+                }
+            }
+            //based on position draw siopao
+            for (auto [entity, position, animation, sling] : Siopao.each()) {
+                DrawTextureRec(siopao_texture.Get(), animation.frameRec, position.position, WHITE);
+                if (sling_down && !late_latch_line) {
+                    DrawSlingLine(position, animation, sling, mouse_position);
+                }
+            }
+            for (auto entity: visible_platforms) {
+                SizeComponent& size = registry.get<SizeComponent>(entity);
+                PositionComponent& position = registry.get<PositionComponent>(entity);
+                ColorComponent& color = registry.get<ColorComponent>(entity);
+
+                DrawRectangle(position.position.x, position.position.y, size.width, size.height, color.color);
             }
+            ui_library.Draw();
+        }
+
+        {
+            PROFILE_SCOPE("Frame pacing");
+            frame_pacer.Wait();
         }
-        for (auto entity: Platform) {
-            SizeComponent& size = registry.get<SizeComponent>(entity);
-            PositionComponent& position = registry.get<PositionComponent>(entity);
-            ColorComponent& color = registry.get<ColorComponent>(entity);
 
-            DrawRectangle(position.position.x, position.position.y, size.width, size.height, color.color);
+        // Nothing is actually drawn before EndDrawing flushes raylib's batch, so the
+        // line only goes on now, with the cursor as of right before the swap
+        if (late_latch_line) {
+            PROFILE_SCOPE("Late latch");
+            mouse_position = LatchMousePosition();
+            latency.CursorLatched();
+            for (auto [entity, position, animation, sling] : Siopao.each()) {
+                DrawSlingLine(position, animation, sling, mouse_position);
+            }
         }
-        ui_library.Draw();
+
+        PROFILE_SCOPE("EndDrawing");
         EndDrawing();
+        latency.Swapped(sling_down, late_latch_line);
+        latency.InputPolled();
     }
 
+    if (recording_input) {
+        if (recording.Save(record_path)) {
+            std::cout << "Recorded " << recording.GetTickCount() << " ticks to " << record_path << std::endl;
+        }
+        else {
+            std::cout << "Could not save " << record_path << std::endl;
+        }
+    }
+
+    PrintPacingStats(frame_pacer, std::cout);
+    PrintLatencyStats(latency, std::cout);
+    if (race) {
+        // So the other game doesn't keep waiting for us
+        race->Leave();
+        race->Print(std::cout);
+    }
+    if (!always_draw) {
+        std::cout << "Drew " << idle.GetDrawnFrames() << " frames, skipped " << idle.GetSkippedFrames() << " that looked the same" << std::endl;
+    }
+    SaveTrace(trace_path);
+
+    ResourceManager::GetInstance()->UnloadAllTextures();
     CloseWindow();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,159 @@
+#ifndef ARENA
+#define ARENA
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Bump allocator: hands out memory from big blocks and never frees anything
+// on its own. Everything is freed at once by Reset() or when the arena is
+// destroyed, so whatever uses it has to be gone by then.
+// Not thread safe; only the thread that owns it may allocate.
+class Arena {
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    unsigned char* current = nullptr;
+    size_t remaining = 0;
+    bool sealed = false;
+
+    // Every block is twice as big as the last, up to MAX_BLOCK_SIZE
+    static const size_t MAX_BLOCK_SIZE = 16 << 20;
+    size_t first_block_size;
+    size_t next_block_size;
+
+    size_t bytes_used = 0;
+    size_t bytes_reserved = 0;
+
+    void AddBlock(size_t min_size) {
+        size_t size = std::max(next_block_size, min_size);
+        next_block_size = std::min(next_block_size * 2, MAX_BLOCK_SIZE);
+
+        blocks.push_back({std::make_unique<unsigned char[]>(size), size});
+        current = blocks.back().memory.get();
+        remaining = size;
+        bytes_reserved += size;
+    }
+
+public:
+    explicit Arena(size_t block_size = 64 << 10) : first_block_size(block_size), next_block_size(block_size) {}
+
+    Arena(const Arena&) = delete;
+    void operator=(const Arena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment) {
+        void* pointer = current;
+        if (current == nullptr || std::align(alignment, size, pointer, remaining) == nullptr) {
+            AddBlock(size + alignment);
+            pointer = current;
+            std::align(alignment, size, pointer, remaining);
+        }
+
+        current = static_cast<unsigned char*>(pointer) + size;
+        remaining -= size;
+        bytes_used += size;
+        return pointer;
+    }
+
+    // Frees everything the arena ever handed out
+    void Reset() {
+        blocks.clear();
+        current = nullptr;
+        remaining = 0;
+        sealed = false;
+        next_block_size = first_block_size;
+        bytes_used = 0;
+        bytes_reserved = 0;
+    }
+
+    // Done loading: ArenaAllocators stop using the arena from here on (see ArenaAllocator)
+    void Seal() {
+        sealed = true;
+    }
+
+    bool IsSealed() const {
+        return sealed;
+    }
+
+    // Whether the memory came from this arena
+    bool Owns(const void* pointer) const {
+        const unsigned char* bytes = static_cast<const unsigned char*>(pointer);
+        for (const Block& block : blocks) {
+            if (bytes >= block.memory.get() && bytes < block.memory.get() + block.size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Bytes handed out, including ones the user is done with (they're only freed by Reset)
+    size_t GetBytesUsed() const {
+        return bytes_used;
+    }
+
+    // Bytes taken from the heap
+    size_t GetBytesReserved() const {
+        return bytes_reserved;
+    }
+};
+
+// Standard allocator on top of an Arena, so containers (and EnTT storages) can use one.
+// Deallocating arena memory does nothing; it comes back when the arena is reset.
+// A default-constructed one has no arena and just uses new and delete.
+//
+// Once the arena is sealed (after a level is loaded), new allocations come from
+// the heap instead and are deleted as usual. A storage that grows while playing
+// would otherwise leave its old arrays behind in the arena, every time, until
+// the level is unloaded.
+template<typename Type>
+class ArenaAllocator {
+    template<typename Other>
+    friend class ArenaAllocator;
+
+    Arena* arena = nullptr;
+
+public:
+    using value_type = Type;
+
+    ArenaAllocator() {}
+
+    // Not explicit, so a registry can be made straight from an arena
+    ArenaAllocator(Arena* arena) : arena(arena) {}
+
+    template<typename Other>
+    ArenaAllocator(const ArenaAllocator<Other>& other) : arena(other.arena) {}
+
+    Type* allocate(size_t count) {
+        if (arena == nullptr || arena->IsSealed()) {
+            return static_cast<Type*>(::operator new(count * sizeof(Type)));
+        }
+        return static_cast<Type*>(arena->Allocate(count * sizeof(Type), alignof(Type)));
+    }
+
+    void deallocate(Type* pointer, size_t) {
+        if (arena == nullptr || !arena->Owns(pointer)) {
+            ::operator delete(pointer);
+        }
+    }
+
+    Arena* GetArena() const {
+        return arena;
+    }
+
+    template<typename Other>
+    bool operator==(const ArenaAllocator<Other>& other) const {
+        return arena == other.arena;
+    }
+
+    template<typename Other>
+    bool operator!=(const ArenaAllocator<Other>& other) const {
+        return arena != other.arena;
+    }
+};
+
+#endif
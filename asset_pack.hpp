@@ -0,0 +1,258 @@
+#ifndef ASSET_PACK
+#define ASSET_PACK
+
+#include <raylib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "entt.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Packed asset archive made by asset_packer.cpp.
+// Images are stored already decoded (raw pixels, in raylib's pixel format),
+// so loading one is just handing a pointer into the file to the GPU upload.
+//
+// Layout:
+//   AssetPackHeader
+//   AssetPackEntry[entry_count]   (the index)
+//   pixel data, each payload starting on an ASSET_PACK_ALIGNMENT boundary
+//
+// Entries are looked up by the entt::hashed_string of the path the asset was
+// packed from (e.g. "assets/steamer.png"), the same id the resource manager uses.
+// Values are stored in the byte order of the machine that made the pack, so a pack
+// made on a little-endian machine won't open on a big-endian one (the version won't match).
+
+const char ASSET_PACK_MAGIC[8] = {'S', 'I', 'O', 'P', 'A', 'C', 'K', '\0'};
+const uint32_t ASSET_PACK_VERSION = 1;
+const uint64_t ASSET_PACK_ALIGNMENT = 64;
+// Bigger images are rejected, which also keeps GetPixelDataSize (an int) from overflowing
+const int32_t ASSET_PACK_MAX_IMAGE_SIZE = 8192;
+
+struct AssetPackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+};
+
+struct AssetPackEntry {
+    uint32_t id;
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Read-only view of an asset pack.
+// The file is memory-mapped where possible, so opening it doesn't read the pixel
+// data; pages are only faulted in when a texture is uploaded from them.
+class AssetPack {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+
+    // Used instead of the mapping on platforms without mmap
+    std::vector<unsigned char> buffer;
+
+    const AssetPackEntry* entries = nullptr;
+    uint32_t entry_count = 0;
+
+    bool ReadIndex() {
+        if (size < sizeof(AssetPackHeader)) {
+            return false;
+        }
+
+        const AssetPackHeader* header = (const AssetPackHeader*) data;
+        if (memcmp(header->magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0 ||
+            header->version != ASSET_PACK_VERSION ||
+            size < sizeof(AssetPackHeader) + header->entry_count * sizeof(AssetPackEntry)) {
+            return false;
+        }
+
+        entries = (const AssetPackEntry*) (data + sizeof(AssetPackHeader));
+        entry_count = header->entry_count;
+
+        // A stale or corrupt pack could otherwise hand the GPU upload a pointer past the end
+        for (uint32_t i = 0; i < entry_count; i++) {
+            const AssetPackEntry& entry = entries[i];
+            if (entry.offset > size || entry.size > size - entry.offset) {
+                return false;
+            }
+
+            if (entry.width <= 0 || entry.height <= 0 ||
+                entry.width > ASSET_PACK_MAX_IMAGE_SIZE || entry.height > ASSET_PACK_MAX_IMAGE_SIZE) {
+                return false;
+            }
+
+            // Unknown formats have no size, so they're rejected here too
+            int pixel_size = GetPixelDataSize(entry.width, entry.height, entry.format);
+            if (pixel_size <= 0 || entry.size < uint64_t(pixel_size)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+public:
+    AssetPack() {}
+
+    AssetPack(const AssetPack&) = delete;
+    void operator=(const AssetPack&) = delete;
+
+    ~AssetPack() {
+        Close();
+    }
+
+    // Opens the pack at the specified path. Returns false if it's missing or invalid.
+    bool Open(const std::string& path) {
+        Close();
+
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+
+        data = (const unsigned char*) mapping;
+        size = info.st_size;
+        mapped = true;
+#else
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        fseek(file, 0, SEEK_END);
+        buffer.resize(ftell(file));
+        fseek(file, 0, SEEK_SET);
+        size_t read = fread(buffer.data(), 1, buffer.size(), file);
+        fclose(file);
+
+        if (read != buffer.size()) {
+            buffer.clear();
+            return false;
+        }
+
+        data = buffer.data();
+        size = buffer.size();
+#endif
+
+        if (!ReadIndex()) {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapped) {
+            munmap((void*) data, size);
+        }
+#endif
+
+        buffer.clear();
+        data = nullptr;
+        size = 0;
+        mapped = false;
+        entries = nullptr;
+        entry_count = 0;
+    }
+
+    bool IsOpen() const {
+        return data != nullptr;
+    }
+
+    uint32_t GetEntryCount() const {
+        return entry_count;
+    }
+
+    // Finds an image by id. The returned Image points straight into the pack,
+    // so it must not be passed to UnloadImage, and is only valid while the pack is open.
+    // Returns false if the pack doesn't contain it.
+    bool GetImage(entt::id_type id, Image& image) const {
+        for (uint32_t i = 0; i < entry_count; i++) {
+            if (entries[i].id == id) {
+                image.data = (void*) (data + entries[i].offset);
+                image.width = entries[i].width;
+                image.height = entries[i].height;
+                image.mipmaps = 1;
+                image.format = entries[i].format;
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+// Writes an asset pack holding the specified images, stored under the specified ids.
+// Used by asset_packer.cpp. Returns false if the file couldn't be written.
+inline bool WriteAssetPack(const std::string& path, const std::vector<entt::id_type>& ids, const std::vector<Image>& images) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    AssetPackHeader header;
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = uint32_t(images.size());
+
+    // Lay out the payloads after the index, each one aligned
+    std::vector<AssetPackEntry> entries(images.size());
+    uint64_t offset = sizeof(AssetPackHeader) + images.size() * sizeof(AssetPackEntry);
+
+    for (size_t i = 0; i < images.size(); i++) {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+
+        entries[i].id = ids[i];
+        entries[i].width = images[i].width;
+        entries[i].height = images[i].height;
+        entries[i].format = images[i].format;
+        entries[i].offset = offset;
+        entries[i].size = uint64_t(GetPixelDataSize(images[i].width, images[i].height, images[i].format));
+
+        offset += entries[i].size;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(entries.data(), sizeof(AssetPackEntry), entries.size(), file) == entries.size();
+
+    for (size_t i = 0; i < images.size() && ok; i++) {
+        // Pad up to the payload's offset
+        static const unsigned char padding[ASSET_PACK_ALIGNMENT] = {};
+        uint64_t position = uint64_t(ftell(file));
+        ok = fwrite(padding, 1, size_t(entries[i].offset - position), file) == size_t(entries[i].offset - position);
+
+        ok = ok && fwrite(images[i].data, 1, size_t(entries[i].size), file) == size_t(entries[i].size);
+    }
+
+    return fclose(file) == 0 && ok;
+}
+
+#endif
@@ -0,0 +1,81 @@
+#include <raylib.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.hpp"
+#include "entt.hpp"
+
+// Compares how long it takes to get the game's textures onto the GPU
+// from the loose PNGs versus from the asset pack.
+//
+// Usage (after running asset_packer with the same paths):
+//   asset_pack_benchmark [pack] [runs]
+// Defaults to assets/assets.pack and 50 runs.
+
+const char* texture_paths[] = {
+    "assets/siopao spritesheet.png",
+    "assets/steamer.png"
+};
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    std::string pack_path = argc > 1 ? argv[1] : "assets/assets.pack";
+    int runs = argc > 2 ? std::stoi(argv[2]) : 50;
+
+    // A (hidden) window is needed for a GPU context to upload to
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(64, 64, "Asset Pack Benchmark");
+
+    double png_total = 0.0;
+    double pack_total = 0.0;
+    std::vector<Texture> textures;
+
+    for (int run = 0; run < runs; run++) {
+        // Loose PNGs: read, decode and upload each file
+        auto start = std::chrono::steady_clock::now();
+        for (const char* path : texture_paths) {
+            textures.push_back(LoadTexture(path));
+        }
+        png_total += ElapsedMs(start);
+
+        for (Texture& texture : textures) {
+            UnloadTexture(texture);
+        }
+        textures.clear();
+
+        // Asset pack: map the file and upload straight from it
+        start = std::chrono::steady_clock::now();
+        AssetPack pack;
+        if (!pack.Open(pack_path)) {
+            std::cout << "Could not open " << pack_path << ", run asset_packer first" << std::endl;
+            CloseWindow();
+            return 1;
+        }
+
+        for (const char* path : texture_paths) {
+            Image image;
+            if (pack.GetImage(entt::hashed_string{path}, image)) {
+                textures.push_back(LoadTextureFromImage(image));
+            }
+        }
+        pack_total += ElapsedMs(start);
+
+        for (Texture& texture : textures) {
+            UnloadTexture(texture);
+        }
+        textures.clear();
+    }
+
+    std::cout << "Loose PNGs: " << png_total / runs << " ms per startup" << std::endl;
+    std::cout << "Asset pack: " << pack_total / runs << " ms per startup" << std::endl;
+
+    CloseWindow();
+    return 0;
+}
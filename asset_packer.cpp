@@ -0,0 +1,56 @@
+#include <raylib.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.hpp"
+#include "entt.hpp"
+
+// Packs images into an asset pack (see asset_pack.hpp), decoding them once here
+// instead of on every launch of the game.
+//
+// Usage, from the folder the game is run from:
+//   asset_packer assets/assets.pack "assets/siopao spritesheet.png" assets/steamer.png
+//
+// Images are stored under the hash of the path exactly as given,
+// so use the same paths the game loads them with.
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "Usage: " << argv[0] << " <output pack> <image> [image...]" << std::endl;
+        return 1;
+    }
+
+    std::vector<entt::id_type> ids;
+    std::vector<Image> images;
+
+    for (int i = 2; i < argc; i++) {
+        Image image = LoadImage(argv[i]);
+        if (image.data == nullptr) {
+            std::cout << "Could not load " << argv[i] << std::endl;
+            return 1;
+        }
+
+        // Store everything as plain RGBA so the game can upload it as is
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+        ids.push_back(entt::hashed_string{argv[i]});
+        images.push_back(image);
+
+        std::cout << "Packed " << argv[i] << " (" << image.width << "x" << image.height << ")" << std::endl;
+    }
+
+    bool ok = WriteAssetPack(argv[1], ids, images);
+
+    for (Image& image : images) {
+        UnloadImage(image);
+    }
+
+    if (!ok) {
+        std::cout << "Could not write " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << argv[1] << std::endl;
+    return 0;
+}
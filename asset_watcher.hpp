@@ -0,0 +1,101 @@
+#ifndef ASSET_WATCHER
+#define ASSET_WATCHER
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "scene_manager.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Watches an asset directory and hot-reloads textures whenever their files change,
+// so assets can be tweaked without restarting the game.
+// Changed files are re-decoded on the resource manager's workers and swapped in
+// by ResourceManager::UploadPendingTextures(), so that still has to be called every frame.
+// Paths are reported as directory + "/" + file name, which has to match the path the
+// texture was loaded with (e.g. watching "assets" covers "assets/steamer.png").
+// Only implemented on Linux (inotify); elsewhere the watcher does nothing.
+class AssetWatcher {
+    std::string directory;
+    std::atomic<bool> stopping{false};
+    std::thread watcher;
+
+#ifdef __linux__
+    int inotify_fd = -1;
+
+    void WatchLoop() {
+        // inotify events are variable-length, so read into a buffer big enough for several
+        alignas(inotify_event) char buffer[4096];
+        pollfd poll_fd = {inotify_fd, POLLIN, 0};
+
+        while (!stopping) {
+            // Wake up regularly to check whether we should stop
+            if (poll(&poll_fd, 1, 100) <= 0) {
+                continue;
+            }
+
+            ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                continue;
+            }
+
+            for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + ((inotify_event*) ptr)->len) {
+                inotify_event* event = (inotify_event*) ptr;
+                if (event->len == 0) {
+                    continue;
+                }
+
+                ResourceManager::GetInstance()->ReloadTextureAsync(directory + "/" + event->name);
+            }
+        }
+    }
+#endif
+
+public:
+    explicit AssetWatcher(const std::string& directory) : directory(directory) {
+#ifdef __linux__
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0) {
+            std::cout << "Could not start watching " << directory << std::endl;
+            return;
+        }
+
+        // IN_CLOSE_WRITE catches files saved in place, IN_MOVED_TO catches editors
+        // that write to a temporary file and rename it over the original
+        if (inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            std::cout << "Could not start watching " << directory << std::endl;
+            close(inotify_fd);
+            inotify_fd = -1;
+            return;
+        }
+
+        watcher = std::thread([this] { WatchLoop(); });
+#else
+        std::cout << "Asset hot-reload is only supported on Linux" << std::endl;
+#endif
+    }
+
+    AssetWatcher(const AssetWatcher&) = delete;
+    void operator=(const AssetWatcher&) = delete;
+
+    ~AssetWatcher() {
+        stopping = true;
+        if (watcher.joinable()) {
+            watcher.join();
+        }
+
+#ifdef __linux__
+        if (inotify_fd >= 0) {
+            close(inotify_fd);
+        }
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef BINARY_FILE
+#define BINARY_FILE
+
+#include <cstdint>
+#include <cstdio>
+
+// Whether the file still has at least size bytes after where it's at.
+// The binary files say in their header how much follows; checking that first
+// means a corrupt header fails the load instead of allocating whatever it claims.
+inline bool HasBytesLeft(FILE* file, uint64_t size) {
+    long position = ftell(file);
+    if (position < 0 || fseek(file, 0, SEEK_END) != 0) {
+        return false;
+    }
+
+    long end = ftell(file);
+    bool ok = end >= position && uint64_t(end - position) >= size;
+
+    return fseek(file, position, SEEK_SET) == 0 && ok;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef COMPONENTS
+#define COMPONENTS
+
+#include <raylib.h>
+
+#include "entt.hpp"
+
+// ECS structs
+// Kept trivially copyable, so snapshots can store them as raw bytes
+
+struct PositionComponent {
+    Vector2 position;
+};
+struct SizeComponent {
+    int width;
+    int height;
+};
+struct ColorComponent {
+    Color color;
+};
+struct VelocityComponent {
+    Vector2 velocity;
+    float speed;
+};
+struct CircleColliderComponent {
+    Vector2 center;
+    int radius;
+    bool onFloor;
+};
+// Forces from the player's input this tick, applied by the force system
+struct ForceComponent {
+    Vector2 force;
+};
+
+struct PointComponent
+{
+    bool point;
+};
+
+// Sling Mechanic, every body pulls its own sling from the same input
+struct SlingComponent {
+    Vector2 initialMousePos;
+    Vector2 currentMousePos;
+    float force;
+    float lineThickness;
+};
+struct AnimationComponent {
+    Rectangle frameRec;
+    float frameSelector;
+    float frameTimer;
+};
+
+// The platforms a body landed on for the first time this tick, written by the
+// collision system and scored afterwards by the scoring system. Any more than
+// CONTACT_MAX_LANDINGS in one tick are still unscored next tick, so they get picked up then.
+const int CONTACT_MAX_LANDINGS = 8;
+struct ContactComponent {
+    entt::entity landed[CONTACT_MAX_LANDINGS];
+    int landed_count;
+};
+
+// The player's own Siopao. Only he scores, and only him falling off restarts the level.
+struct PlayerComponent {};
+
+#endif
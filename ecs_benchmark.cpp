@@ -0,0 +1,210 @@
+#include <raylib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "entt.hpp"
+
+// Headless benchmark of the ways EnTT can go through entities, grown out of
+// ecs-sample.cpp: the same circles, rectangles and square_circles, just a lot
+// more of them and no window.
+//
+// Every pattern does the same work (moving shapes like the sample does):
+//   registry_get    view, then registry.get for each component (what the sample does)
+//   view_get        view, then view.get
+//   each_callback   view.each(func)
+//   each_binding    for (auto [entity, ...] : view.each())
+//   group           non-owning group
+//   owning_group    owning group (owns the components, so they're packed in order)
+//   runtime_view    entt::runtime_view, then registry.get
+// over two workloads:
+//   circles         every entity with a circle (CircleComponent + PositionComponent)
+//   square_circles  only the ones that are both (CircleComponent + RectangleComponent + PositionComponent)
+// at different overlaps: the fraction of entities that are square_circles.
+// The rest are split between plain circles and plain rectangles.
+//
+// Prints CSV on stdout, one line per pattern, workload, entity count and overlap:
+//   pattern,workload,entities,overlap,matched,ms_per_pass,ns_per_match
+//
+// Usage:
+//   ecs_benchmark [max entities] [samples]
+// Defaults to 10000000 entities (about 1 GB of memory at the top) and 5 samples,
+// keeping the best one.
+
+struct PositionComponent {
+    Vector2 position;
+};
+
+struct CircleComponent {
+    float radius;
+};
+
+struct RectangleComponent {
+    float width;
+    float height;
+};
+
+struct ColorComponent {
+    Color color;
+};
+
+const float DT = 1.0f / 60.0f;
+
+// The circles fall, like in the sample
+void MoveCircle(CircleComponent& circle, PositionComponent& position) {
+    position.position.y += 100 * DT * circle.radius;
+}
+
+// The square_circles slide along their diagonal
+void MoveSquareCircle(CircleComponent& circle, RectangleComponent& rectangle, PositionComponent& position) {
+    position.position.x += 100 * DT * rectangle.width;
+    position.position.y += 100 * DT * (rectangle.height - circle.radius);
+}
+
+// Creates count entities, each with a position and a color. A fraction (overlap) of
+// them are square_circles, with both shapes; the others alternate between circles and rectangles.
+void CreateShapes(entt::registry& registry, size_t count, double overlap) {
+    std::vector<entt::entity> entities(count);
+    registry.create(entities.begin(), entities.end());
+    registry.insert<PositionComponent>(entities.begin(), entities.end());
+    registry.insert<ColorComponent>(entities.begin(), entities.end(), ColorComponent{GREEN});
+
+    for (size_t i = 0; i < count; i++) {
+        // Spread the square_circles evenly instead of bunching them at the start
+        bool both = size_t((i + 1) * overlap) > size_t(i * overlap);
+
+        if (both || i % 2 == 0) {
+            registry.emplace<CircleComponent>(entities[i], 25.0f);
+        }
+        if (both || i % 2 == 1) {
+            registry.emplace<RectangleComponent>(entities[i], 50.0f, 50.0f);
+        }
+    }
+}
+
+// Runs pass(func) until there's enough work to time, a few times over, and
+// returns the best time of a single pass in milliseconds.
+template<typename Pass>
+double TimePasses(size_t count, int samples, Pass pass) {
+    // At least about a million entities per sample, so small counts can still be timed
+    size_t passes_per_sample = std::max(size_t(1), size_t(1000000) / count);
+
+    double best_ms = 0.0;
+    for (int sample = 0; sample < samples; sample++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < passes_per_sample; i++) {
+            pass();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / passes_per_sample;
+        best_ms = sample == 0 ? ms : std::min(best_ms, ms);
+    }
+    return best_ms;
+}
+
+void PrintResult(const char* pattern, const char* workload, size_t count, double overlap, size_t matched, double ms) {
+    std::cout << pattern << "," << workload << "," << count << "," << overlap << "," << matched << ","
+              << ms << "," << (matched > 0 ? ms * 1e6 / matched : 0.0) << std::endl;
+}
+
+// Every pattern that doesn't change how the registry stores things, on one registry.
+// Type... are the components the workload uses, in the order func takes them.
+template<typename... Type, typename Func>
+void RunViewPatterns(entt::registry& registry, const char* workload, size_t count, double overlap, int samples, Func func) {
+    auto view = registry.view<Type...>();
+
+    size_t matched = 0;
+    view.each([&matched](auto&...) { matched++; });
+
+    PrintResult("registry_get", workload, count, overlap, matched, TimePasses(count, samples, [&] {
+        for (auto entity : view) {
+            func(registry.get<Type>(entity)...);
+        }
+    }));
+
+    PrintResult("view_get", workload, count, overlap, matched, TimePasses(count, samples, [&] {
+        for (auto entity : view) {
+            std::apply(func, view.template get<Type...>(entity));
+        }
+    }));
+
+    PrintResult("each_callback", workload, count, overlap, matched, TimePasses(count, samples, [&] {
+        view.each(func);
+    }));
+
+    PrintResult("each_binding", workload, count, overlap, matched, TimePasses(count, samples, [&] {
+        if constexpr (sizeof...(Type) == 2) {
+            for (auto [entity, first, second] : view.each()) {
+                func(first, second);
+            }
+        }
+        else {
+            for (auto [entity, first, second, third] : view.each()) {
+                func(first, second, third);
+            }
+        }
+    }));
+
+    // Non-owning groups only keep a list of their entities, so they don't get in the way of the next workload
+    auto group = registry.group<>(entt::get<Type...>);
+    PrintResult("group", workload, count, overlap, matched, TimePasses(count, samples, [&] {
+        group.each(func);
+    }));
+
+    entt::runtime_view runtime_view;
+    (runtime_view.iterate(registry.storage<Type>()), ...);
+    PrintResult("runtime_view", workload, count, overlap, matched, TimePasses(count, samples, [&] {
+        for (auto entity : runtime_view) {
+            func(registry.get<Type>(entity)...);
+        }
+    }));
+}
+
+// Owning groups sort the storages they own, so every one gets a registry of its own
+template<typename... Type, typename Func>
+void RunOwningGroup(const char* workload, size_t count, double overlap, int samples, Func func) {
+    entt::registry registry;
+    CreateShapes(registry, count, overlap);
+
+    auto group = registry.group<Type...>();
+    PrintResult("owning_group", workload, count, overlap, group.size(), TimePasses(count, samples, [&] {
+        group.each(func);
+    }));
+}
+
+int main(int argc, char** argv) {
+    size_t max_count = argc > 1 ? size_t(std::stoull(argv[1])) : 10000000;
+    int samples = argc > 2 ? std::max(1, std::stoi(argv[2])) : 5;
+
+    const double overlaps[] = {0.0, 0.01, 0.1, 0.5, 1.0};
+
+    // Lambdas rather than function pointers, so every pattern can inline the work
+    auto move_circle = [](CircleComponent& circle, PositionComponent& position) {
+        MoveCircle(circle, position);
+    };
+    auto move_square_circle = [](CircleComponent& circle, RectangleComponent& rectangle, PositionComponent& position) {
+        MoveSquareCircle(circle, rectangle, position);
+    };
+
+    std::cout << "pattern,workload,entities,overlap,matched,ms_per_pass,ns_per_match" << std::endl;
+
+    for (size_t count = 1000; count <= max_count; count *= 10) {
+        for (double overlap : overlaps) {
+            {
+                entt::registry registry;
+                CreateShapes(registry, count, overlap);
+
+                RunViewPatterns<CircleComponent, PositionComponent>(registry, "circles", count, overlap, samples, move_circle);
+                RunViewPatterns<CircleComponent, RectangleComponent, PositionComponent>(registry, "square_circles", count, overlap, samples, move_square_circle);
+            }
+
+            RunOwningGroup<CircleComponent, PositionComponent>("circles", count, overlap, samples, move_circle);
+            RunOwningGroup<CircleComponent, RectangleComponent, PositionComponent>("square_circles", count, overlap, samples, move_square_circle);
+        }
+    }
+
+    return 0;
+}
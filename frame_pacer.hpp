@@ -0,0 +1,220 @@
+#ifndef FRAME_PACER
+#define FRAME_PACER
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <thread>
+
+#include "frame_stats.hpp"
+
+// Waits for the next frame instead of SetTargetFPS. raylib's wait is one coarse
+// sleep (or a busy loop, depending on how it was built), so frames come out a
+// millisecond or two early or late. The pacer sleeps until shortly before the
+// deadline, which costs no CPU, and spins for the rest, which is exact.
+//
+// With vsync the swap already waits for the display, so the pacer doesn't wait at
+// all; it measures the display's actual refresh interval instead (monitors that
+// say 60 Hz are often 59.94) and reports how far each frame is off it. Drivers and
+// compositors often ignore the vsync hint, though, and then nothing waits at all;
+// when frames keep coming much faster than the display refreshes, the pacer goes
+// back to waiting itself.
+//
+// Call Wait() right before EndDrawing, so the swap (and the input polling raylib
+// does after it) happens as close to the deadline as possible.
+
+// How long before the deadline the pacer stops sleeping and starts spinning.
+// Sleeps overshoot by up to about this much (raylib asks Windows for 1 ms timers).
+const double FRAME_PACER_SPIN_MS = 1.0;
+
+// Frames in a row under half the refresh interval before vsync is taken to be ignored
+const size_t FRAME_PACER_VSYNC_FALLBACK_FRAMES = 30;
+
+// About 17 seconds at 60 FPS, like FrameStats
+const size_t FRAME_PACER_STATS_SIZE = 1024;
+
+class FramePacer {
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    Milliseconds interval;
+    Clock::time_point deadline;
+    Clock::time_point last_frame;
+    bool started = false;
+
+    // With vsync: the swap waits, and interval is the measured refresh interval
+    bool display_sync = false;
+    // Frames in a row that came too fast for vsync to be working
+    size_t fast_frames = 0;
+
+    // The last frame wasn't shown, so the next one isn't lined up with the display
+    bool skipped = false;
+
+    // How late each frame was, and the time between frames
+    LatencySamples<FRAME_PACER_STATS_SIZE> error_ms;
+    LatencySamples<FRAME_PACER_STATS_SIZE> frame_ms;
+    size_t frames = 0;
+    size_t missed = 0;
+
+    void Record(Clock::time_point now, double error) {
+        error_ms.Add(float(error));
+        frame_ms.Add(float(Milliseconds(now - last_frame).count()));
+        frames++;
+    }
+
+    // Sleeps, then spins, until the deadline. Returns when it got there.
+    Clock::time_point WaitUntil(Clock::time_point now) {
+        auto wake = deadline - std::chrono::duration_cast<Clock::duration>(Milliseconds(FRAME_PACER_SPIN_MS));
+        if (now < wake) {
+            std::this_thread::sleep_until(wake);
+        }
+        while ((now = Clock::now()) < deadline) {
+        }
+        return now;
+    }
+
+public:
+    explicit FramePacer(double fps) : interval(1000.0 / fps) {}
+
+    // Leaves the waiting to vsync, starting from the refresh rate the monitor reports
+    void SyncToDisplay(int refresh_rate) {
+        display_sync = true;
+        if (refresh_rate > 0) {
+            interval = Milliseconds(1000.0 / refresh_rate);
+        }
+    }
+
+    bool IsSyncedToDisplay() const {
+        return display_sync;
+    }
+
+    // Waits until it's time to show the frame
+    void Wait() {
+        Clock::time_point now = Clock::now();
+        if (!started) {
+            started = true;
+            deadline = now;
+            last_frame = now;
+            return;
+        }
+
+        if (display_sync && skipped) {
+            skipped = false;
+            last_frame = now;
+            return;
+        }
+
+        if (display_sync) {
+            // Frames within 10% of the refresh interval refine it; the others missed a refresh
+            double elapsed = Milliseconds(now - last_frame).count();
+            if (std::abs(elapsed - interval.count()) < interval.count() * 0.1) {
+                interval = Milliseconds(interval.count() + (elapsed - interval.count()) / 16);
+            }
+            else if (elapsed > interval.count()) {
+                missed++;
+            }
+            Record(now, elapsed - interval.count());
+            last_frame = now;
+
+            fast_frames = elapsed < interval.count() * 0.5 ? fast_frames + 1 : 0;
+            if (fast_frames >= FRAME_PACER_VSYNC_FALLBACK_FRAMES) {
+                // The swap isn't waiting, so the frames are paced like without vsync from now on
+                display_sync = false;
+                deadline = now;
+            }
+            return;
+        }
+
+        deadline += std::chrono::duration_cast<Clock::duration>(interval);
+
+        if (now >= deadline) {
+            // The frame took too long. A frame or less behind, the next one is
+            // shortened to catch up; further behind, the schedule starts over.
+            missed++;
+            Record(now, Milliseconds(now - deadline).count());
+            if (now - deadline > interval) {
+                deadline = now;
+            }
+        }
+        else {
+            now = WaitUntil(now);
+            Record(now, Milliseconds(now - deadline).count());
+        }
+        last_frame = now;
+    }
+
+    // For frames that aren't shown: sleeps until the next one is due, without
+    // spinning (a late wake-up shows nowhere) and without counting it in the stats.
+    // Without a swap to wait on, vsync frames are timed like this too.
+    void Skip() {
+        Clock::time_point now = Clock::now();
+        if (!started) {
+            started = true;
+            last_frame = now;
+        }
+
+        if (display_sync) {
+            deadline = last_frame;
+        }
+        deadline += std::chrono::duration_cast<Clock::duration>(interval);
+
+        if (now < deadline) {
+            std::this_thread::sleep_until(deadline);
+            now = Clock::now();
+        }
+        else if (now - deadline > interval) {
+            deadline = now;
+        }
+
+        skipped = true;
+        last_frame = now;
+    }
+
+    // The frame interval being aimed for
+    float GetTargetMs() const {
+        return float(interval.count());
+    }
+
+    size_t GetFrameCount() const {
+        return frames;
+    }
+
+    size_t GetMissedCount() const {
+        return missed;
+    }
+
+    // How late the given fraction of recent frames (0.5 for the median) were at most
+    float GetErrorPercentile(float fraction) {
+        return error_ms.GetPercentile(fraction);
+    }
+
+    // Standard deviation of the time between recent frames
+    float GetJitterMs() const {
+        size_t count = frame_ms.GetCount();
+        if (count < 2) {
+            return 0.0f;
+        }
+
+        double mean = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            mean += frame_ms.Get(i);
+        }
+        mean /= count;
+
+        double variance = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            variance += (frame_ms.Get(i) - mean) * (frame_ms.Get(i) - mean);
+        }
+        return float(std::sqrt(variance / (count - 1)));
+    }
+};
+
+inline void PrintPacingStats(FramePacer& pacer, std::ostream& out) {
+    out << "Frame pacing (" << (pacer.IsSyncedToDisplay() ? "vsync" : "timer") << ", " << pacer.GetTargetMs() << " ms frames): "
+        << "late by p50 " << pacer.GetErrorPercentile(0.5f) << " ms, p99 " << pacer.GetErrorPercentile(0.99f)
+        << " ms, worst " << pacer.GetErrorPercentile(1.0f) << " ms; jitter " << pacer.GetJitterMs() << " ms; missed "
+        << pacer.GetMissedCount() << " of " << pacer.GetFrameCount() << " frames" << std::endl;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef FRAME_STATS
+#define FRAME_STATS
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+// Frame times of the last few seconds, for the debug overlay (F3).
+// Kept in fixed-size ring buffers, so recording a frame never allocates,
+// and the percentiles show the stalls an average would hide.
+
+// About 17 seconds at 60 FPS
+const size_t FRAME_STATS_SIZE = 1024;
+
+// The histogram has one bin per millisecond; the last bin also holds everything slower
+const int FRAME_HISTOGRAM_BINS = 50;
+const float FRAME_HISTOGRAM_MS_PER_BIN = 1.0f;
+
+// The latest few samples in milliseconds (frame times, latencies...) with their
+// percentiles. Once it's full, each new sample overwrites the oldest one.
+template<size_t Size>
+class LatencySamples {
+    std::array<float, Size> samples = {};
+    size_t next = 0;
+    size_t count = 0;
+
+    // The samples in order, worked out again when a percentile is asked for after a new sample
+    std::array<float, Size> sorted = {};
+    bool sorted_dirty = false;
+
+public:
+    void Add(float ms) {
+        samples[next] = ms;
+        next = (next + 1) % Size;
+        count = std::min(count + 1, Size);
+        sorted_dirty = true;
+    }
+
+    size_t GetCount() const {
+        return count;
+    }
+
+    // The sample at index, counting from the oldest one held
+    float Get(size_t index) const {
+        size_t oldest = count < Size ? 0 : next;
+        return samples[(oldest + index) % Size];
+    }
+
+    float GetLatest() const {
+        return count > 0 ? samples[(next + Size - 1) % Size] : 0.0f;
+    }
+
+    // The sample that the given fraction of samples (0.5 for the median) were at most
+    float GetPercentile(float fraction) {
+        if (count == 0) {
+            return 0.0f;
+        }
+
+        if (sorted_dirty) {
+            std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+            std::sort(sorted.begin(), sorted.begin() + count);
+            sorted_dirty = false;
+        }
+        size_t rank = size_t(std::ceil(fraction * count));
+        return sorted[std::min(std::max(rank, size_t(1)), count) - 1];
+    }
+};
+
+class FrameStats {
+    LatencySamples<FRAME_STATS_SIZE> frame_ms;
+    // One per frame, alongside frame_ms
+    std::array<int, FRAME_STATS_SIZE> physics_steps = {};
+    size_t next_steps = 0;
+
+    // How far the physics loop was behind at the end of the latest frame
+    float backlog_ms = 0.0f;
+
+public:
+    // Records a frame, overwriting the oldest one once the buffer is full
+    void Add(float ms, int steps, float backlog) {
+        frame_ms.Add(ms);
+        physics_steps[next_steps] = steps;
+        next_steps = (next_steps + 1) % FRAME_STATS_SIZE;
+
+        backlog_ms = backlog;
+    }
+
+    size_t GetCount() const {
+        return frame_ms.GetCount();
+    }
+
+    float GetLatestMs() const {
+        return frame_ms.GetLatest();
+    }
+
+    int GetLatestSteps() const {
+        return GetCount() > 0 ? physics_steps[(next_steps + FRAME_STATS_SIZE - 1) % FRAME_STATS_SIZE] : 0;
+    }
+
+    int GetMaxSteps() const {
+        return GetCount() > 0 ? *std::max_element(physics_steps.begin(), physics_steps.begin() + GetCount()) : 0;
+    }
+
+    float GetBacklogMs() const {
+        return backlog_ms;
+    }
+
+    // The frame time that the given fraction of frames (0.5 for the median) were at most
+    float GetPercentile(float fraction) {
+        return frame_ms.GetPercentile(fraction);
+    }
+
+    float GetWorstMs() {
+        return GetPercentile(1.0f);
+    }
+
+    // How many of the frames fall into each bin
+    void GetHistogram(std::array<int, FRAME_HISTOGRAM_BINS>& bins) const {
+        bins.fill(0);
+        for (size_t i = 0; i < frame_ms.GetCount(); i++) {
+            int bin = int(frame_ms.Get(i) / FRAME_HISTOGRAM_MS_PER_BIN);
+            bins[std::min(std::max(bin, 0), FRAME_HISTOGRAM_BINS - 1)]++;
+        }
+    }
+};
+
+#endif
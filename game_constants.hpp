@@ -0,0 +1,27 @@
+#ifndef GAME_CONSTANTS
+#define GAME_CONSTANTS
+
+// The physics constants, shared by the game and the level generator
+// (so generated levels are always reachable with the real jump).
+
+const float TARGET_FPS = 60;
+const float TIMESTEP = 1 / TARGET_FPS;
+
+// Game Constants
+const float gravity = 500.0f;
+const float drag = 1.0f;
+
+// Stats
+const float playerMoveSpeed = 20.0f;
+const float playerSlingPower = 10.0f;
+
+const float playerMaxHorizontalVelocity = 500.0f;
+const float playerMaxVerticalVelocity = 800.0f;
+
+const float playerAcceleration = 0.5f;
+const float playerDeceleration = 10.0f;
+
+// Siopao's sprite (and collision) size
+const float playerSize = 64.0f;
+
+#endif
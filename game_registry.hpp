@@ -0,0 +1,41 @@
+#ifndef GAME_REGISTRY
+#define GAME_REGISTRY
+
+#include <type_traits>
+
+#include "arena.hpp"
+#include "entt.hpp"
+
+// The game's registry keeps all of its memory in an Arena: every component
+// storage (dense and sparse arrays, pages) gets the registry's allocator, so a
+// level's storages sit together in a few big blocks instead of all over the heap,
+// and unloading a level frees them all at once instead of one by one.
+//
+// Since the allocator is part of the storage types, views and the organizer
+// need the matching types too; use the aliases below instead of entt::registry,
+// entt::view and entt::organizer for the game's world.
+
+using GameRegistry = entt::basic_registry<entt::entity, ArenaAllocator<entt::entity>>;
+
+// Same as entt::view<entt::get_t<Get...>>, for the game's registry
+template<typename... Get>
+using GameView = entt::basic_view<entt::get_t<entt::storage_for_t<Get, entt::entity, ArenaAllocator<std::remove_const_t<Get>>>...>, entt::exclude_t<>>;
+
+using GameOrganizer = entt::basic_organizer<GameRegistry>;
+
+// One level's registry, along with the arena its storages live in.
+// Destroying it unloads the level with a single arena reset; the registry goes
+// first, and its deallocations cost nothing since the arena ignores them
+// (apart from anything allocated after the arena was sealed, see ArenaAllocator).
+// Seal the arena once the level is loaded.
+struct LevelWorld {
+    Arena arena;
+    GameRegistry registry{&arena};
+
+    LevelWorld() {}
+
+    LevelWorld(const LevelWorld&) = delete;
+    void operator=(const LevelWorld&) = delete;
+};
+
+#endif
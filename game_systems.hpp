@@ -0,0 +1,359 @@
+#ifndef GAME_SYSTEMS
+#define GAME_SYSTEMS
+
+#include <raylib.h>
+#include <raymath.h>
+
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_constants.hpp"
+#include "game_registry.hpp"
+#include "input_recorder.hpp"
+#include "level.hpp"
+#include "platform_grid.hpp"
+#include "platform_sort.hpp"
+#include "system_scheduler.hpp"
+
+// The game's systems: one tick of physics split into steps that each declare
+// which components and context variables they read and write (through their
+// parameters), so the SystemScheduler can run the ones that don't touch the
+// same data at the same time.
+//
+// The systems only read input through the TickInput in the registry's context,
+// so recorded input still replays exactly.
+
+// Everything besides the registry that the systems carry over from one tick to
+// the next, kept in the registry's context. What every body has for itself
+// (its sling and sprite frame) are components instead.
+struct ScoreState {
+    int death_counter = 0;
+    int score = -1;
+
+    // Set by the tick Siopao fell off the screen; the world is restored after the tick
+    bool respawn = false;
+    // Set once Siopao reached the steamer basket
+    bool won = false;
+};
+
+// The steamer basket Siopao has to reach (where it goes comes from the level)
+const Rectangle frameRecSteamer = {0, 0, 64, 48};
+
+inline Vector2 GetClosestPointAABBCircle(Vector2 sioPos, Vector2 rectPos, Vector2 rectSize) {
+    return {Clamp(sioPos.x, rectPos.x, rectPos.x + rectSize.x),
+            Clamp(sioPos.y, rectPos.y, rectPos.y + rectSize.y)};
+}
+
+// Works out the score from the platforms' points, for after the world was restored.
+// The score is one less than the number of platforms landed on.
+inline int CountScore(GameRegistry& registry) {
+    int points = -1;
+    for (auto entity: registry.view<PointComponent>()) {
+        if (registry.get<PointComponent>(entity).point) {
+            points += 1;
+        }
+    }
+    return points;
+}
+
+// Puts the platform storages back in Z-order when platforms changed since the last
+// tick (seen by the grid's observer, before the broadphase takes the changes).
+// Takes the whole registry, so it runs on its own.
+inline void PlatformSortSystem(GameRegistry& registry) {
+    size_t changed = registry.ctx().get<PlatformGrid>().GetPendingChanges();
+    if (changed > 0) {
+        ResortPlatforms(registry, changed);
+    }
+}
+
+// Moves the platforms that changed since the last tick into their new grid cells
+inline void BroadphaseSystem(GameView<const PositionComponent, const SizeComponent> platforms, PlatformGrid& grid) {
+    grid.Update(platforms);
+}
+
+// Lands one body on platforms and bumps it off their sides, and notes down the
+// platforms it landed on for the first time (is_scored says which ones already scored).
+// Only the platforms in the grid cells around it are checked.
+template<typename Platforms, typename IsScored>
+void CollideBody(const PositionComponent& position, VelocityComponent& velocity, CircleColliderComponent& collider, ContactComponent& contact,
+                 const Platforms& platforms, const PlatformGrid& grid, IsScored is_scored) {
+    // One list per thread, so it doesn't have to be allocated for every body
+    thread_local std::vector<entt::entity> candidates;
+
+    // Player Info
+    float playerBottomBound = position.position.y + playerSize;
+    float playerLeftBound = position.position.x;
+    float playerRightBound = position.position.x + playerSize;
+
+    collider.onFloor = false;
+    contact.landed_count = 0;
+
+    //For each platform close enough to touch
+    grid.Query({position.position.x, position.position.y, playerSize, playerSize}, platforms, candidates);
+    for (entt::entity platform : candidates) {
+        const PositionComponent& rect_pos_comp = platforms.template get<const PositionComponent>(platform);
+        const SizeComponent& rect_size_comp = platforms.template get<const SizeComponent>(platform);
+
+        //Clamp siopao to the platform
+        Vector2 closestPoint = GetClosestPointAABBCircle(Vector2Add(position.position, {playerSize/2,playerSize/2}), rect_pos_comp.position, {float (rect_size_comp.width), float (rect_size_comp.height)});
+
+        float platformLeftBound = rect_pos_comp.position.x;
+        float platformRightBound = rect_pos_comp.position.x + rect_size_comp.width;
+        float platformUpperBound = rect_pos_comp.position.y;
+
+        //if siopao is touching it
+        if (Vector2Distance(Vector2Add(position.position, {playerSize/2,playerSize/2}), closestPoint) <= playerSize/2) {
+            if (playerBottomBound <= platformUpperBound + rect_size_comp.height/2) {
+                collider.onFloor = true;
+                if (!is_scored(platform) && contact.landed_count < CONTACT_MAX_LANDINGS) {
+                    contact.landed[contact.landed_count] = platform;
+                    contact.landed_count += 1;
+                }
+            }
+            else {
+                if (playerLeftBound > platformLeftBound &&
+                    velocity.velocity.x < 0.0f) {
+
+                    velocity.velocity.x = 5.0f;
+                }
+                if (playerRightBound < platformRightBound &&
+                    velocity.velocity.x > 0.0f) {
+
+                    velocity.velocity.x = -5.0f;
+                }
+            }
+        }
+    }
+}
+
+// Winning (reaching the steamer basket) and dying (falling off the bottom)
+inline void CheckGoalAndFall(const PositionComponent& position, const LevelInfo& level, ScoreState& score) {
+    if((Vector2Distance(Vector2Add(position.position, {playerSize/2,playerSize/2}), Vector2Add(level.goal, {frameRecSteamer.width/2,frameRecSteamer.height/2})) <= playerSize/2)) {
+        score.score = 1000;
+        score.won = true;
+    }
+
+    // Reaching Bottom Edge of Screen
+    if (position.position.y + playerSize >= level.height) {
+        // The world is restored once the tick is over
+        score.respawn = true;
+        score.death_counter = score.death_counter + 1;
+
+        score.score = -1;
+    }
+}
+
+// Collision for every body (see CollideBody).
+// Every body only changes its own components, so big crowds are split across threads.
+inline void CollisionSystem(GameView<const PositionComponent, VelocityComponent, CircleColliderComponent, ContactComponent> bodies,
+                            GameView<const PositionComponent, const SizeComponent, const PointComponent> platforms,
+                            const PlatformGrid& grid, const SystemThreads& threads) {
+    auto is_scored = [&platforms](entt::entity platform) {
+        return platforms.get<const PointComponent>(platform).point;
+    };
+
+    ParallelEach(threads, bodies, [&platforms, &grid, &is_scored](const PositionComponent& position, VelocityComponent& velocity, CircleColliderComponent& collider, ContactComponent& contact) {
+        CollideBody(position, velocity, collider, contact, platforms, grid, is_scored);
+    });
+}
+
+// Scores the platforms the player landed on, then checks for winning and dying.
+// Only the player's Siopao counts; the rest of a crowd just starts over at the
+// spawn point when it falls off (see BoundsSystem).
+inline void ScoringSystem(GameView<const PositionComponent, const ContactComponent, const PlayerComponent> players,
+                          GameView<PointComponent> platforms, const LevelInfo& level, ScoreState& score) {
+    for (auto [entity, position, contact] : players.each()) {
+        // Patched rather than written through the view, so the rewind buffer sees it
+        for (int i = 0; i < contact.landed_count; i++) {
+            if (!platforms.get<PointComponent>(contact.landed[i]).point) {
+                platforms.storage<PointComponent>().patch(contact.landed[i], [](PointComponent& point) { point.point = true; });
+                score.score += 1;
+            }
+        }
+
+        CheckGoalAndFall(position, level, score);
+    }
+}
+
+// Keeps Siopao inside the level's top, left and right edges, and puts him back
+// at the spawn point when he falls off the bottom. For the player that's undone
+// anyway by restoring the whole world after the tick; the rest of a crowd
+// carries on from there.
+// Every body is independent, so big crowds are split across threads.
+inline void BoundsSystem(GameView<PositionComponent, VelocityComponent> bodies,
+                         const LevelInfo& level, const SystemThreads& threads) {
+    ParallelEach(threads, bodies, [&level](PositionComponent& position, VelocityComponent& velocity) {
+        // Reaching Bottom Edge of Screen
+        if (position.position.y + playerSize >= level.height) {
+            position.position = level.spawn;
+            velocity.velocity = {0.0f, 0.0f};
+        }
+
+        if (position.position.y <= 0) {
+            if (velocity.velocity.y != 0.0f) {
+                velocity.velocity.y = 0.0f;
+            }
+            position.position.y = 0;
+        }
+
+        // Reaching Right Corner of Screen
+        if (position.position.x + playerSize >= level.width) {
+            if (velocity.velocity.x > 0.0f) {
+                velocity.velocity.x = 0.0f;
+            }
+            position.position.x = level.width - playerSize;
+        }
+
+        // Reaching Left Corner of Screen
+        if (position.position.x <= 0) {
+            if (velocity.velocity.x < 0.0f) {
+                velocity.velocity.x = 0.0f;
+            }
+            position.position.x = 0.0f;
+        }
+    });
+}
+
+// Turns the tick's input into forces on Siopao while he's on the floor:
+// walking with A and D, and the sling with the mouse.
+// Every body is independent, so big crowds are split across threads.
+inline void InputSystem(GameView<const CircleColliderComponent, ForceComponent, SlingComponent, AnimationComponent> bodies,
+                        const TickInput& input, const SystemThreads& threads) {
+    ParallelEach(threads, bodies, [&input](const CircleColliderComponent& collider, ForceComponent& force, SlingComponent& sling, AnimationComponent& animation) {
+        // Totaling every force done on the player at a given frame
+        Vector2 playerForces = {0, 0};
+
+        if (collider.onFloor) {
+            //Basic Movement
+            if(input.move_left) {
+                animation.frameRec.x = (64*4);
+                playerForces = Vector2Add(playerForces, {-playerMoveSpeed, 0});
+            }
+            if(input.move_right) {
+                animation.frameRec.x = (64*3);
+                playerForces = Vector2Add(playerForces, {playerMoveSpeed, 0});
+            }
+
+            // Sling Mechanic
+            if (input.sling_pressed) {
+                sling.initialMousePos = input.mouse_position;
+                sling.force = 0.0f;
+            }
+            if (sling.initialMousePos.x != 0 && sling.initialMousePos.y != 0) {
+                while (input.sling_down) {
+                    sling.currentMousePos = input.mouse_position;
+                    sling.force += TIMESTEP;
+                    sling.lineThickness += TIMESTEP;
+
+                    animation.frameSelector = 2;
+
+                    animation.frameRec.x = (64*animation.frameSelector);
+
+                    break;
+                }
+            }
+            if (input.sling_released) {
+                playerForces = Vector2Add(playerForces,Vector2Scale(Vector2Negate(Vector2Subtract(sling.currentMousePos, sling.initialMousePos)),Clamp(sling.force,0.0f,5.0f) * 2.0f));
+                sling.lineThickness = 0.0f;
+            }
+        }
+
+        force.force = playerForces;
+    });
+}
+
+// Applies the input forces, gravity and drag, then moves Siopao.
+// Every body is independent, so big crowds are split across threads.
+inline void ForceSystem(GameView<PositionComponent, VelocityComponent, const CircleColliderComponent, const ForceComponent> bodies,
+                        const SystemThreads& threads) {
+    ParallelEach(threads, bodies, [](PositionComponent& position, VelocityComponent& velocity, const CircleColliderComponent& collider, const ForceComponent& force) {
+        // Apply Player Forces
+        velocity.velocity = Vector2Add(velocity.velocity, force.force);
+
+        if (!collider.onFloor) {
+            // Gravity
+            velocity.velocity = Vector2Add(velocity.velocity, {0.0f, gravity * TIMESTEP * 2});
+            velocity.velocity = Vector2Subtract(velocity.velocity, {velocity.velocity.x * drag * TIMESTEP * 2, 0.0f});
+        }
+        else {
+            // Stop on platform
+            if (velocity.velocity.y > 0.0f) {
+                velocity.velocity.y = 0.0f;
+            }
+
+            if (velocity.velocity.y == 0.0f) {
+                // Deceleration Horizontal
+                velocity.velocity = Vector2Subtract(velocity.velocity, {velocity.velocity.x * playerDeceleration * TIMESTEP, 0.0f});
+            }
+        }
+
+        // Keep within Max Velocity
+        velocity.velocity = {Clamp(velocity.velocity.x, -playerMaxHorizontalVelocity, playerMaxHorizontalVelocity),
+                             Clamp(velocity.velocity.y, -playerMaxVerticalVelocity, playerMaxVerticalVelocity)};
+
+        //just add velocity to position per timestep
+        position.position = Vector2Add(position.position, Vector2Scale(velocity.velocity, TIMESTEP));
+    });
+}
+
+// Picks Siopao's sprite frame: facing the way he flies, or cycling while idle.
+// Every body is independent, so big crowds are split across threads.
+inline void AnimationSystem(GameView<const VelocityComponent, const CircleColliderComponent, AnimationComponent> bodies,
+                            const SystemThreads& threads) {
+    ParallelEach(threads, bodies, [](const VelocityComponent& velocity, const CircleColliderComponent& collider, AnimationComponent& animation) {
+        if (!collider.onFloor) {
+            if (velocity.velocity.x < 0.0f) {
+                animation.frameSelector = 4;
+                animation.frameRec.x = (64*animation.frameSelector);
+            }
+            if (velocity.velocity.x > 0.0f) {
+                animation.frameSelector = 3;
+                animation.frameRec.x = (64*animation.frameSelector);
+            }
+        }
+
+        animation.frameTimer += TIMESTEP;
+
+        if (animation.frameTimer > 0.2f) {
+            animation.frameSelector += 1;
+            if (animation.frameSelector > 2) {
+                animation.frameSelector = 0;
+            }
+            animation.frameTimer = 0.0f;
+        }
+
+        if (abs(velocity.velocity.x) < 0.1f &&
+            abs(velocity.velocity.y) < 0.1f) {
+            animation.frameRec.x = (64*animation.frameSelector);
+        }
+    });
+}
+
+// Puts the systems' state into the registry's context, starting from scratch
+inline void CreateGameState(GameRegistry& registry) {
+    registry.ctx().insert_or_assign(ScoreState());
+    registry.ctx().insert_or_assign(TickInput());
+
+    // The grid keeps itself up to date from then on, so there's only ever one per registry
+    PlatformGrid& grid = registry.ctx().emplace<PlatformGrid>();
+    if (!grid.IsConnected()) {
+        grid.Connect(registry);
+    }
+}
+
+// One tick of physics, in the order the steps used to run in, except for animation.
+// The idle frame used to be picked at the start of the tick, from last tick's velocity;
+// now the whole animation runs last, so it sees the velocity after this tick's forces.
+// Only the sprite frame changes because of it, never the physics.
+// The scheduler keeps this order wherever two systems share data.
+inline void AddTickSystems(SystemScheduler& scheduler) {
+    scheduler.Add<&PlatformSortSystem>("platform sort");
+    scheduler.Add<&BroadphaseSystem>("broadphase");
+    scheduler.Add<&CollisionSystem>("collision");
+    scheduler.Add<&ScoringSystem>("scoring");
+    scheduler.Add<&BoundsSystem>("bounds");
+    scheduler.Add<&InputSystem>("input");
+    scheduler.Add<&ForceSystem>("forces");
+    scheduler.Add<&AnimationSystem>("animation");
+}
+
+#endif
@@ -0,0 +1,572 @@
+#ifndef GHOST_RACE
+#define GHOST_RACE
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#include "entt.hpp"
+#include "game_constants.hpp"
+#include "game_registry.hpp"
+#include "game_systems.hpp"
+#include "input_recorder.hpp"
+#include "level.hpp"
+#include "rewind_buffer.hpp"
+#include "system_scheduler.hpp"
+#include "udp_socket.hpp"
+#include "world_snapshot.hpp"
+
+// Two players racing through the same level, each seeing the other's Siopao as
+// a ghost (the ghosts don't touch each other), with GGPO-style rollback.
+//
+// Both games send their input every frame. The other player's Siopao runs in a
+// world of its own (the ghost world), simulated in step with ours. Where their
+// input hasn't arrived yet, it's predicted (they keep holding whatever they held);
+// when it arrives and the prediction was wrong, the ghost world is put back to
+// the tick it went wrong on and simulated again up to now, all within the frame.
+//
+// The ghost world only has the bodies in it. The platforms never move, so the
+// ghost's systems read them straight from our world (and its grid); the points
+// the ghost scored are kept in the ghost world's context instead of on the platforms.
+// The ghost world is saved after every tick with a RewindBuffer (only what changed
+// since the tick before, with a full copy every few ticks), plus the systems'
+// state from its context, so going back is a handful of memcpys.
+// Our own world never needs rolling back, since their input doesn't touch it.
+//
+// Both games need the same level (and --bodies); packets from a different one
+// are ignored. Rewinding (R) is off while racing.
+//
+// A game that closes tells the other one how many ticks it played, so the other one
+// stops waiting for it. A game that crashes (or whose last packets all got lost)
+// can't, so a game that stops answering for GHOST_PEER_TIMEOUT_SECONDS is treated
+// as if it finished where its input stopped, and anything it sends after is ignored.
+
+// How far our game may get ahead of the other player's input before it waits
+// for them. That's also the furthest a rollback ever goes back.
+const uint32_t ROLLBACK_MAX_TICKS = 15;
+// Enough saved ticks to always have a keyframe at least ROLLBACK_MAX_TICKS back
+const uint32_t ROLLBACK_KEYFRAME_INTERVAL = 8;
+const uint32_t ROLLBACK_CAPACITY = 32;
+
+// Inputs sent per packet: everything the other player hasn't acknowledged yet,
+// up to this many, so a lost packet is covered by the next one
+const uint32_t GHOST_PACKET_MAX_INPUTS = 64;
+
+const char GHOST_PACKET_MAGIC[4] = {'S', 'I', 'O', 'G'};
+const uint32_t GHOST_PACKET_VERSION = 1;
+const uint64_t GHOST_NOT_FINISHED = UINT64_MAX;
+
+// How long the other game can go quiet, while we still need its input, before it's taken to be gone
+const double GHOST_PEER_TIMEOUT_SECONDS = 3.0;
+// How long it has to be quiet before the player is told we're waiting for it
+const double GHOST_WAITING_SECONDS = 0.5;
+// Times the last packets are sent when leaving, in case some get lost
+const int GHOST_LEAVE_REPEATS = 3;
+
+// Packet format: GhostPacketHeader, then input_count inputs from first_tick on,
+// each a byte of flags and the mouse position (GHOST_INPUT_SIZE bytes).
+// Both ends are the same game on the same machine, so nothing is byte-swapped.
+struct GhostPacketHeader {
+    char magic[4];
+    uint32_t version;
+    // Hash of the level, so two different levels don't race each other
+    uint64_t world_hash;
+    // How many of the receiver's inputs the sender has
+    uint64_t ack;
+    uint64_t first_tick;
+    // How many ticks the sender played in total, once it's done (GHOST_NOT_FINISHED until then)
+    uint64_t final_tick;
+    uint32_t input_count;
+    uint32_t padding;
+};
+
+const size_t GHOST_INPUT_SIZE = 1 + 2 * sizeof(float);
+
+// The level the ghost world plays in: the platforms of our own world, read only
+struct SharedLevel {
+    const GameRegistry* level = nullptr;
+};
+
+// The platforms the ghost scored. Only ever added to, so rolling it back is just
+// going back to an earlier count.
+struct GhostPoints {
+    std::vector<entt::entity> scored;
+    // Where the points of the current life start (falling off starts a new one)
+    size_t life_start = 0;
+
+    bool IsScored(entt::entity platform) const {
+        return std::find(scored.begin() + life_start, scored.end(), platform) != scored.end();
+    }
+};
+
+// The systems' state from the ghost world's context, saved along with each tick
+// (the rest, like each body's sling, is in the rollback buffer's components)
+struct GhostTickState {
+    ScoreState score;
+    size_t points_scored;
+    size_t points_life_start;
+};
+
+// CollisionSystem, against the shared level's platforms
+inline void GhostCollisionSystem(GameView<const PositionComponent, VelocityComponent, CircleColliderComponent, ContactComponent> bodies,
+                                 const SharedLevel& shared, const GhostPoints& points, const SystemThreads& threads) {
+    auto platforms = shared.level->view<const PositionComponent, const SizeComponent>();
+    const PlatformGrid& grid = shared.level->ctx().get<PlatformGrid>();
+    auto is_scored = [&points](entt::entity platform) {
+        return points.IsScored(platform);
+    };
+
+    ParallelEach(threads, bodies, [&platforms, &grid, &is_scored](const PositionComponent& position, VelocityComponent& velocity, CircleColliderComponent& collider, ContactComponent& contact) {
+        CollideBody(position, velocity, collider, contact, platforms, grid, is_scored);
+    });
+}
+
+// ScoringSystem, keeping the points in GhostPoints
+inline void GhostScoringSystem(GameView<const PositionComponent, const ContactComponent, const PlayerComponent> players,
+                               const LevelInfo& level, GhostPoints& points, ScoreState& score) {
+    for (auto [entity, position, contact] : players.each()) {
+        for (int i = 0; i < contact.landed_count; i++) {
+            if (!points.IsScored(contact.landed[i])) {
+                points.scored.push_back(contact.landed[i]);
+                score.score += 1;
+            }
+        }
+
+        CheckGoalAndFall(position, level, score);
+        if (score.respawn) {
+            // Our world gets its platforms' points back by being restored; this one starts a new life
+            points.life_start = points.scored.size();
+        }
+    }
+}
+
+// AddTickSystems for the ghost world: the same order, without the platforms' own systems
+inline void AddGhostTickSystems(SystemScheduler& scheduler) {
+    scheduler.Add<&GhostCollisionSystem>("collision");
+    scheduler.Add<&GhostScoringSystem>("scoring");
+    scheduler.Add<&BoundsSystem>("bounds");
+    scheduler.Add<&InputSystem>("input");
+    scheduler.Add<&ForceSystem>("forces");
+    scheduler.Add<&AnimationSystem>("animation");
+}
+
+// Copies the components a body has (see CreateSiopao) from one world into another
+template<typename... Type>
+void CopyBody(const GameRegistry& from, entt::entity source, GameRegistry& to) {
+    entt::entity body = to.create();
+    (to.emplace<Type>(body, from.get<Type>(source)), ...);
+    if (from.all_of<PlayerComponent>(source)) {
+        to.emplace<PlayerComponent>(body);
+    }
+}
+
+class GhostRace {
+    using Clock = std::chrono::steady_clock;
+
+    enum : uint8_t {
+        MOVE_LEFT = 1 << 0,
+        MOVE_RIGHT = 1 << 1,
+        SLING_PRESSED = 1 << 2,
+        SLING_DOWN = 1 << 3,
+        SLING_RELEASED = 1 << 4,
+    };
+
+    UdpSocket socket;
+    uint64_t world_hash = 0;
+    bool wrong_level = false;
+
+    // Our input for every tick so far, and how much of it the other player has
+    std::vector<TickInput> local_inputs;
+    uint64_t local_final = GHOST_NOT_FINISHED;
+    uint64_t peer_ack = 0;
+
+    // Their input, every tick from the start up to the latest one that arrived
+    std::vector<TickInput> remote_inputs;
+    uint64_t remote_final = GHOST_NOT_FINISHED;
+
+    // When the last packet from them arrived, and whether they went quiet for good
+    Clock::time_point last_heard;
+    bool peer_gone = false;
+
+    LevelWorld ghost;
+    SystemScheduler ghost_systems{nullptr};
+    // The ghost world before the first tick, for respawning
+    WorldSnapshot ghost_start;
+
+    // Tick b of the rollback buffer is the ghost world after b ticks; the rings
+    // below are indexed the same way
+    RewindBuffer rollback{ROLLBACK_CAPACITY, ROLLBACK_KEYFRAME_INTERVAL};
+    std::vector<GhostTickState> saved_states;
+    // The input each ghost tick was simulated with, to find wrong predictions
+    std::vector<TickInput> used_inputs;
+
+    uint64_t ghost_ticks = 0;
+    // The first tick simulated with a wrong prediction
+    uint64_t rollback_from = GHOST_NOT_FINISHED;
+
+    size_t rollbacks = 0;
+    size_t resimulated_ticks = 0;
+    double rollback_ms = 0.0;
+    double worst_rollback_ms = 0.0;
+    size_t worst_rollback_ticks = 0;
+
+    std::vector<unsigned char> packet;
+
+    static bool IsSameInput(const TickInput& a, const TickInput& b) {
+        return a.move_left == b.move_left && a.move_right == b.move_right &&
+               a.sling_pressed == b.sling_pressed && a.sling_down == b.sling_down && a.sling_released == b.sling_released &&
+               a.mouse_position.x == b.mouse_position.x && a.mouse_position.y == b.mouse_position.y && a.rewind == b.rewind;
+    }
+
+    void WriteInput(const TickInput& input) {
+        uint8_t flags = (input.move_left ? MOVE_LEFT : 0) | (input.move_right ? MOVE_RIGHT : 0) |
+                        (input.sling_pressed ? SLING_PRESSED : 0) | (input.sling_down ? SLING_DOWN : 0) |
+                        (input.sling_released ? SLING_RELEASED : 0);
+
+        size_t offset = packet.size();
+        packet.resize(offset + GHOST_INPUT_SIZE);
+        packet[offset] = flags;
+        memcpy(packet.data() + offset + 1, &input.mouse_position.x, sizeof(float));
+        memcpy(packet.data() + offset + 1 + sizeof(float), &input.mouse_position.y, sizeof(float));
+    }
+
+    TickInput ReadInput(size_t offset) const {
+        TickInput input;
+        uint8_t flags = packet[offset];
+        input.move_left = flags & MOVE_LEFT;
+        input.move_right = flags & MOVE_RIGHT;
+        input.sling_pressed = flags & SLING_PRESSED;
+        input.sling_down = flags & SLING_DOWN;
+        input.sling_released = flags & SLING_RELEASED;
+        memcpy(&input.mouse_position.x, packet.data() + offset + 1, sizeof(float));
+        memcpy(&input.mouse_position.y, packet.data() + offset + 1 + sizeof(float), sizeof(float));
+        return input;
+    }
+
+    void ReadPacket() {
+        GhostPacketHeader header;
+        if (packet.size() < sizeof(header)) {
+            return;
+        }
+        memcpy(&header, packet.data(), sizeof(header));
+
+        if (memcmp(header.magic, GHOST_PACKET_MAGIC, sizeof(GHOST_PACKET_MAGIC)) != 0 || header.version != GHOST_PACKET_VERSION) {
+            return;
+        }
+        if (header.world_hash != world_hash) {
+            wrong_level = true;
+            return;
+        }
+        if (peer_gone || packet.size() < sizeof(header) + header.input_count * GHOST_INPUT_SIZE) {
+            return;
+        }
+
+        last_heard = Clock::now();
+        peer_ack = std::max(peer_ack, header.ack);
+        remote_final = header.final_tick;
+
+        // Only the ticks right after the ones we have; anything past a gap comes again in a later packet
+        for (uint32_t i = 0; i < header.input_count; i++) {
+            uint64_t tick = header.first_tick + i;
+            if (tick != remote_inputs.size()) {
+                continue;
+            }
+
+            TickInput input = ReadInput(sizeof(header) + i * GHOST_INPUT_SIZE);
+            if (tick < ghost_ticks && !IsSameInput(input, used_inputs[tick % ROLLBACK_CAPACITY])) {
+                rollback_from = std::min(rollback_from, tick);
+            }
+            remote_inputs.push_back(input);
+        }
+    }
+
+    // Their input for the tick if it arrived, otherwise a guess: the same as their
+    // latest input, minus the clicks (holding the button carries on, clicking doesn't)
+    TickInput GetInput(uint64_t tick) const {
+        if (tick < remote_inputs.size()) {
+            return remote_inputs[tick];
+        }
+
+        TickInput input = remote_inputs.empty() ? TickInput() : remote_inputs.back();
+        input.sling_pressed = false;
+        input.sling_released = false;
+        return input;
+    }
+
+    void SaveState(uint64_t tick) {
+        auto& context = ghost.registry.ctx();
+        const GhostPoints& points = context.get<GhostPoints>();
+        saved_states[tick % ROLLBACK_CAPACITY] = {context.get<ScoreState>(), points.scored.size(), points.life_start};
+    }
+
+    void LoadState(uint64_t tick) {
+        const GhostTickState& state = saved_states[tick % ROLLBACK_CAPACITY];
+        ghost.registry.ctx().get<ScoreState>() = state.score;
+        GhostPoints& points = ghost.registry.ctx().get<GhostPoints>();
+        points.scored.resize(state.points_scored);
+        points.life_start = state.points_life_start;
+    }
+
+    // Puts the ghost world back to the start of the level, for when the rollback
+    // buffer doesn't go back far enough (which the stall rule should never allow)
+    void Restart() {
+        LoadWorld(ghost.registry, ghost_start);
+        ghost.registry.ctx().insert_or_assign(ScoreState());
+        ghost.registry.ctx().insert_or_assign(GhostPoints());
+
+        rollback.Clear();
+        rollback.Record(ghost.registry);
+        SaveState(0);
+        ghost_ticks = 0;
+    }
+
+    // Sends our inputs from first_tick on (as many as fit in a packet)
+    void SendInputs(uint64_t first_tick) {
+        GhostPacketHeader header;
+        memcpy(header.magic, GHOST_PACKET_MAGIC, sizeof(GHOST_PACKET_MAGIC));
+        header.version = GHOST_PACKET_VERSION;
+        header.world_hash = world_hash;
+        header.ack = remote_inputs.size();
+        header.first_tick = first_tick;
+        header.final_tick = local_final;
+        header.input_count = uint32_t(std::min<uint64_t>(local_inputs.size() - first_tick, GHOST_PACKET_MAX_INPUTS));
+        header.padding = 0;
+
+        packet.resize(sizeof(header));
+        memcpy(packet.data(), &header, sizeof(header));
+        for (uint32_t i = 0; i < header.input_count; i++) {
+            WriteInput(local_inputs[first_tick + i]);
+        }
+
+        socket.Send(packet);
+    }
+
+    template<typename Tick>
+    void Step(Tick& tick) {
+        TickInput input = GetInput(ghost_ticks);
+        used_inputs[ghost_ticks % ROLLBACK_CAPACITY] = input;
+        tick(ghost.registry, ghost_systems, input, rollback, ghost_start);
+        ghost_ticks++;
+        SaveState(ghost_ticks);
+    }
+
+public:
+    // level is our world before the first tick, which the ghost world starts from
+    // (its platforms are used from then on, so it has to outlive the race), and
+    // level_start a snapshot of it, to tell whether the other game has the same level
+    GhostRace(const GameRegistry& level, const WorldSnapshot& level_start) {
+        // In the order of our velocity storage (views go through it backwards), so the
+        // ghost's bodies come in the same order as the other game's own
+        const auto& bodies = level.storage<VelocityComponent>();
+        for (size_t i = 0; i < bodies.size(); i++) {
+            CopyBody<PositionComponent, VelocityComponent, CircleColliderComponent, ForceComponent,
+                     SlingComponent, AnimationComponent, ContactComponent>(level, bodies.data()[i], ghost.registry);
+        }
+        SaveWorld(ghost.registry, ghost_start);
+
+        ghost.registry.ctx().insert_or_assign(level.ctx().get<LevelInfo>());
+        ghost.registry.ctx().insert_or_assign(SharedLevel{&level});
+        ghost.registry.ctx().insert_or_assign(ScoreState());
+        ghost.registry.ctx().insert_or_assign(GhostPoints());
+        ghost.registry.ctx().insert_or_assign(TickInput());
+
+        // Usually just the one Siopao, so the ghost's systems run on this thread
+        AddGhostTickSystems(ghost_systems);
+        ghost_systems.Build(ghost.registry);
+        ghost.arena.Seal();
+
+        saved_states.resize(ROLLBACK_CAPACITY);
+        used_inputs.resize(ROLLBACK_CAPACITY);
+        rollback.Record(ghost.registry);
+        SaveState(0);
+
+        // FNV-1a over the level
+        world_hash = 14695981039346656037ull;
+        for (unsigned char byte : level_start.data) {
+            world_hash = (world_hash ^ byte) * 1099511628211ull;
+        }
+    }
+
+    GhostRace(const GhostRace&) = delete;
+    void operator=(const GhostRace&) = delete;
+
+    // Races against whoever is on remote_port. Returns false if local_port is taken.
+    bool Connect(uint16_t local_port, uint16_t remote_port, NetConditions conditions) {
+        return socket.Open(local_port, remote_port, conditions);
+    }
+
+    // Whether our game may run another tick, or has to wait for the other player
+    // to catch up (which includes before they started)
+    bool CanAdvance() const {
+        return HasAllRemoteInput() || local_inputs.size() < remote_inputs.size() + ROLLBACK_MAX_TICKS;
+    }
+
+    // Our input for the tick we just ran. Rewinding isn't part of a race.
+    void AddLocalInput(TickInput input) {
+        input.rewind = false;
+        local_inputs.push_back(input);
+    }
+
+    // No more ticks from us (the replay ran out)
+    void Finish() {
+        local_final = local_inputs.size();
+    }
+
+    // Reads whatever arrived, and sends everything the other player is missing.
+    // Call once per frame, after the ticks.
+    void Exchange() {
+        while (socket.Receive(packet)) {
+            ReadPacket();
+        }
+
+        // Quiet for too long while we still need their input: they're gone, and
+        // their ghost ends where their input does
+        if (HasPeer() && !HasAllRemoteInput() && GetSilenceSeconds() > GHOST_PEER_TIMEOUT_SECONDS) {
+            peer_gone = true;
+            remote_final = remote_inputs.size();
+        }
+
+        SendInputs(std::min<uint64_t>(peer_ack, local_inputs.size()));
+        socket.Flush();
+    }
+
+    // Our game is closing: tells the other one, with every input it's still missing,
+    // right away and a few times over, since there won't be another chance
+    void Leave() {
+        Finish();
+
+        for (int repeat = 0; repeat < GHOST_LEAVE_REPEATS; repeat++) {
+            uint64_t first_tick = std::min<uint64_t>(peer_ack, local_inputs.size());
+            do {
+                SendInputs(first_tick);
+                first_tick += GHOST_PACKET_MAX_INPUTS;
+            } while (first_tick < local_inputs.size());
+        }
+        socket.FlushAll();
+    }
+
+    // Brings the ghost world up to our tick (or their last one, once they're done),
+    // rolling back first if a prediction turned out wrong. Once our game is done,
+    // the ghost carries on with just the input that arrived, to the end of theirs.
+    // tick runs one tick of a world, with the same arguments as GameTick.
+    template<typename Tick>
+    void Simulate(Tick tick) {
+        uint64_t target = local_final == GHOST_NOT_FINISHED ? std::min<uint64_t>(local_inputs.size(), remote_final) : remote_inputs.size();
+
+        // Predicted past where the ghost should be (the end of their game, or the
+        // input that arrived once ours is over): go back to there
+        if (ghost_ticks > target) {
+            rollback_from = std::min(rollback_from, target);
+        }
+
+        if (rollback_from < ghost_ticks) {
+            auto start = Clock::now();
+            uint64_t simulated = ghost_ticks;
+
+            if (rollback.RewindTo(ghost.registry, rollback_from)) {
+                LoadState(rollback_from);
+                ghost_ticks = rollback_from;
+            }
+            else {
+                // Too far back for the buffer: slow, but the ghost stays right
+                Restart();
+            }
+            uint64_t from = ghost_ticks;
+            while (ghost_ticks < std::min(simulated, target)) {
+                Step(tick);
+            }
+
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            size_t ticks = size_t(simulated - from);
+            rollbacks++;
+            resimulated_ticks += ticks;
+            rollback_ms += ms;
+            if (ms > worst_rollback_ms) {
+                worst_rollback_ms = ms;
+                worst_rollback_ticks = ticks;
+            }
+        }
+        rollback_from = GHOST_NOT_FINISHED;
+
+        while (ghost_ticks < target) {
+            Step(tick);
+        }
+    }
+
+    const GameRegistry& GetGhost() const {
+        return ghost.registry;
+    }
+
+    bool HasPeer() const {
+        return !remote_inputs.empty() || remote_final != GHOST_NOT_FINISHED;
+    }
+
+    bool IsWrongLevel() const {
+        return wrong_level;
+    }
+
+    // Whether they stopped answering before they were done (see GHOST_PEER_TIMEOUT_SECONDS)
+    bool IsPeerGone() const {
+        return peer_gone;
+    }
+
+    // Seconds since the last packet from them arrived
+    double GetSilenceSeconds() const {
+        return std::chrono::duration<double>(Clock::now() - last_heard).count();
+    }
+
+    // Whether to tell the player we're waiting: before the other game shows up, or
+    // when our game is held up on input from it that's been slow to come
+    bool IsWaiting() const {
+        return !HasPeer() || (!CanAdvance() && GetSilenceSeconds() > GHOST_WAITING_SECONDS);
+    }
+
+    // Both games are done, and each has all of the other's input
+    bool IsComplete() const {
+        return local_final != GHOST_NOT_FINISHED && remote_final != GHOST_NOT_FINISHED &&
+               remote_inputs.size() >= remote_final && ghost_ticks == remote_final && peer_ack >= local_final;
+    }
+
+    // Every tick of theirs arrived (they may still be missing some of ours)
+    bool HasAllRemoteInput() const {
+        return remote_final != GHOST_NOT_FINISHED && remote_inputs.size() >= remote_final;
+    }
+
+    uint64_t GetGhostTick() const {
+        return ghost_ticks;
+    }
+
+    // How many of the ghost's ticks were simulated with guessed input
+    uint64_t GetPredictedTicks() const {
+        return ghost_ticks > remote_inputs.size() ? ghost_ticks - remote_inputs.size() : 0;
+    }
+
+    size_t GetRollbackCount() const {
+        return rollbacks;
+    }
+
+    size_t GetResimulatedTicks() const {
+        return resimulated_ticks;
+    }
+
+    double GetWorstRollbackMs() const {
+        return worst_rollback_ms;
+    }
+
+    // How many times faster than real time the rollbacks re-simulated
+    double GetResimulationSpeed() const {
+        return rollback_ms > 0.0 ? resimulated_ticks * TIMESTEP * 1000.0 / rollback_ms : 0.0;
+    }
+
+    void Print(std::ostream& out) const {
+        out << "Ghost race: " << rollbacks << " rollbacks, " << resimulated_ticks << " ticks simulated again ("
+            << GetResimulationSpeed() << "x real time), worst " << worst_rollback_ms << " ms for " << worst_rollback_ticks << " ticks" << std::endl;
+        out << "Packets: " << socket.GetSentCount() << " sent (" << socket.GetDroppedCount() << " dropped on purpose), "
+            << socket.GetReceivedCount() << " received" << std::endl;
+    }
+};
+
+#endif
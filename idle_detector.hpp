@@ -0,0 +1,105 @@
+#ifndef IDLE_DETECTOR
+#define IDLE_DETECTOR
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Skips drawing frames that would look exactly like the one already on screen,
+// like when Siopao is sitting on a platform and nobody touches anything.
+//
+// Every frame, everything that's about to be drawn is hashed (positions, sprite
+// frames, colors...); if the hash matches the last frame that was drawn and
+// nothing forces a redraw (input, the UI changing, a texture reloading, the window
+// being resized, restored or focused), the frame isn't drawn or swapped at all.
+// The game still ticks as usual, so recordings and replays don't notice; only the
+// drawing stops.
+
+// The highest key code raylib reports (GLFW_KEY_LAST)
+const int IDLE_LAST_KEY = 348;
+
+// Whether any keyboard or mouse input arrived since the last frame.
+// Keys are checked one by one, so raylib's GetKeyPressed queue is left for whoever reads it.
+inline bool HasInput() {
+    for (int key = 1; key <= IDLE_LAST_KEY; key++) {
+        if (IsKeyPressed(key) || IsKeyReleased(key)) {
+            return true;
+        }
+    }
+
+    Vector2 mouse_delta = GetMouseDelta();
+    return mouse_delta.x != 0.0f || mouse_delta.y != 0.0f || GetMouseWheelMove() != 0.0f ||
+           IsMouseButtonDown(MOUSE_BUTTON_LEFT) || IsMouseButtonDown(MOUSE_BUTTON_RIGHT) ||
+           IsMouseButtonReleased(MOUSE_BUTTON_LEFT) || IsMouseButtonReleased(MOUSE_BUTTON_RIGHT);
+}
+
+class IdleDetector {
+    uint64_t hash = 0;
+    uint64_t drawn_hash = 0;
+    bool drawn_any = false;
+
+    size_t drawn_frames = 0;
+    size_t skipped_frames = 0;
+
+    // The window's state as of the last frame
+    bool was_focused = true;
+    bool was_minimized = false;
+
+public:
+    // Starts hashing a new frame
+    void Begin() {
+        hash = 14695981039346656037ull;
+    }
+
+    // Adds something that's drawn to the frame's hash (FNV-1a over its bytes)
+    template<typename Type>
+    void Add(const Type& value) {
+        static_assert(std::is_trivially_copyable_v<Type>, "only plain values can be hashed byte by byte");
+
+        unsigned char bytes[sizeof(Type)];
+        memcpy(bytes, &value, sizeof(Type));
+        for (unsigned char byte : bytes) {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+    }
+
+    // Whether the frame has to be drawn: it looks different from the last drawn
+    // one, or force says so anyway
+    bool NeedsDrawing(bool force) {
+        if (force || !drawn_any || hash != drawn_hash) {
+            drawn_hash = hash;
+            drawn_any = true;
+            drawn_frames++;
+            return true;
+        }
+
+        skipped_frames++;
+        return false;
+    }
+
+    // Whether the window was resized, minimized, restored, or gained or lost focus since
+    // the last frame. Without a compositor, whatever covered the window stays on screen
+    // until the next frame that's drawn, so these always get one.
+    bool WindowChanged() {
+        bool focused = IsWindowFocused();
+        bool minimized = IsWindowMinimized();
+        bool changed = IsWindowResized() || focused != was_focused || minimized != was_minimized;
+
+        was_focused = focused;
+        was_minimized = minimized;
+        return changed;
+    }
+
+    size_t GetDrawnFrames() const {
+        return drawn_frames;
+    }
+
+    size_t GetSkippedFrames() const {
+        return skipped_frames;
+    }
+};
+
+#endif
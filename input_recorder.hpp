@@ -0,0 +1,180 @@
+#ifndef INPUT_RECORDER
+#define INPUT_RECORDER
+
+#include <raylib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "binary_file.hpp"
+
+// The input the physics reads during one tick.
+// The physics only ever reads input through this, so feeding it recorded
+// TickInputs reproduces a session exactly.
+struct TickInput {
+    // KEY_A / KEY_D held
+    bool move_left = false;
+    bool move_right = false;
+
+    // Left mouse button, used by the sling
+    bool sling_pressed = false;
+    bool sling_down = false;
+    bool sling_released = false;
+    Vector2 mouse_position = {0, 0};
+
+    // R held (rewinding)
+    bool rewind = false;
+};
+
+// Reads the current keyboard and mouse state
+inline TickInput SampleTickInput() {
+    TickInput input;
+    input.move_left = IsKeyDown(KEY_A);
+    input.move_right = IsKeyDown(KEY_D);
+    input.sling_pressed = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
+    input.sling_down = IsMouseButtonDown(MOUSE_BUTTON_LEFT);
+    input.sling_released = IsMouseButtonReleased(MOUSE_BUTTON_LEFT);
+    input.mouse_position = GetMousePosition();
+    input.rewind = IsKeyDown(KEY_R);
+    return input;
+}
+
+// A recorded session: one TickInput per tick.
+//
+// Each tick is stored as one byte of flags, followed by the mouse position
+// only while the mouse button is involved (the only time the physics reads it),
+// so an idle tick costs a single byte.
+// File format: InputRecordingHeader, then the ticks.
+const char INPUT_RECORDING_MAGIC[4] = {'S', 'I', 'O', 'R'};
+const uint32_t INPUT_RECORDING_VERSION = 1;
+
+struct InputRecordingHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t tick_count;
+    uint64_t size;
+};
+
+class InputRecording {
+    enum : uint8_t {
+        MOVE_LEFT = 1 << 0,
+        MOVE_RIGHT = 1 << 1,
+        SLING_PRESSED = 1 << 2,
+        SLING_DOWN = 1 << 3,
+        SLING_RELEASED = 1 << 4,
+        REWIND = 1 << 5,
+        HAS_MOUSE = 1 << 6
+    };
+
+    std::vector<unsigned char> data;
+    uint64_t tick_count = 0;
+
+    // Read position for playback
+    size_t offset = 0;
+
+public:
+    // Adds the input of the next tick
+    void Append(const TickInput& input) {
+        uint8_t flags = 0;
+        if (input.move_left) flags |= MOVE_LEFT;
+        if (input.move_right) flags |= MOVE_RIGHT;
+        if (input.sling_pressed) flags |= SLING_PRESSED;
+        if (input.sling_down) flags |= SLING_DOWN;
+        if (input.sling_released) flags |= SLING_RELEASED;
+        if (input.rewind) flags |= REWIND;
+        if (input.sling_pressed || input.sling_down || input.sling_released) flags |= HAS_MOUSE;
+
+        data.push_back(flags);
+
+        if (flags & HAS_MOUSE) {
+            size_t at = data.size();
+            data.resize(at + sizeof(Vector2));
+            memcpy(data.data() + at, &input.mouse_position, sizeof(Vector2));
+        }
+
+        tick_count++;
+    }
+
+    // Gets the input of the next tick during playback.
+    // Returns false once every recorded tick has been played.
+    bool Next(TickInput& input) {
+        if (offset >= data.size()) {
+            return false;
+        }
+
+        uint8_t flags = data[offset++];
+        input.move_left = flags & MOVE_LEFT;
+        input.move_right = flags & MOVE_RIGHT;
+        input.sling_pressed = flags & SLING_PRESSED;
+        input.sling_down = flags & SLING_DOWN;
+        input.sling_released = flags & SLING_RELEASED;
+        input.rewind = flags & REWIND;
+
+        // Without the mouse button involved, the position is left as it was
+        if (flags & HAS_MOUSE) {
+            if (offset + sizeof(Vector2) > data.size()) {
+                return false;
+            }
+
+            memcpy(&input.mouse_position, data.data() + offset, sizeof(Vector2));
+            offset += sizeof(Vector2);
+        }
+
+        return true;
+    }
+
+    // Starts playback over from the first tick
+    void Rewind() {
+        offset = 0;
+    }
+
+    uint64_t GetTickCount() const {
+        return tick_count;
+    }
+
+    bool Save(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        InputRecordingHeader header;
+        memcpy(header.magic, INPUT_RECORDING_MAGIC, sizeof(INPUT_RECORDING_MAGIC));
+        header.version = INPUT_RECORDING_VERSION;
+        header.tick_count = tick_count;
+        header.size = data.size();
+
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && fwrite(data.data(), 1, data.size(), file) == data.size();
+
+        return fclose(file) == 0 && ok;
+    }
+
+    bool Load(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        InputRecordingHeader header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+                  memcmp(header.magic, INPUT_RECORDING_MAGIC, sizeof(INPUT_RECORDING_MAGIC)) == 0 &&
+                  header.version == INPUT_RECORDING_VERSION &&
+                  HasBytesLeft(file, header.size);
+
+        if (ok) {
+            data.resize(size_t(header.size));
+            ok = fread(data.data(), 1, data.size(), file) == data.size();
+            tick_count = header.tick_count;
+            offset = 0;
+        }
+
+        fclose(file);
+        return ok;
+    }
+};
+
+#endif
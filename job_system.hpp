@@ -0,0 +1,279 @@
+#ifndef JOB_SYSTEM
+#define JOB_SYSTEM
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "entt.hpp"
+#include "profiler.hpp"
+
+// Work-stealing job system shared by everything that runs in parallel:
+// the game's systems, ParallelFor passes over entities and asset decoding.
+//
+// Every worker has its own deque of jobs. A worker runs its newest job first
+// (what it just spawned is likely still in cache) and, when its deque is empty,
+// steals the oldest job from another one. Threads that aren't workers (like the
+// main thread) share one more deque.
+//
+// Jobs can be tracked with a JobCounter: it counts the jobs started with it that
+// haven't finished yet, and Wait() runs other jobs until it reaches zero, so a
+// job can start child jobs and wait for them without tying up its thread.
+//
+// Long jobs that nobody waits for right away (decoding images) go on a separate
+// background queue, which only the workers take from, so waiting on the main
+// thread never ends up stuck in one of them.
+
+// Counts unfinished jobs. Must outlive the jobs started with it.
+class JobCounter {
+    std::atomic<int> pending{0};
+    friend class JobSystem;
+
+public:
+    JobCounter() {}
+
+    JobCounter(const JobCounter&) = delete;
+    void operator=(const JobCounter&) = delete;
+
+    bool IsDone() const {
+        return pending == 0;
+    }
+};
+
+class JobSystem {
+    struct Job {
+        std::function<void()> func;
+        JobCounter* counter = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    // One per worker, then the one shared by every other thread
+    std::vector<std::unique_ptr<Queue>> queues;
+    Queue background;
+
+    std::vector<std::thread> workers;
+
+    // Jobs in all the queues, so idle workers know when to wake up
+    std::atomic<int> queued{0};
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false};
+
+    // Which queue the calling thread owns
+    struct ThreadInfo {
+        const JobSystem* owner = nullptr;
+        size_t queue = 0;
+    };
+
+    static ThreadInfo& GetThreadInfo() {
+        static thread_local ThreadInfo info;
+        return info;
+    }
+
+    size_t GetOwnQueue() const {
+        const ThreadInfo& info = GetThreadInfo();
+        return info.owner == this ? info.queue : queues.size() - 1;
+    }
+
+    void Push(Queue& queue, Job job) {
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+        queued++;
+
+        // Taking the lock makes sure a worker about to sleep sees the job
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+        wake.notify_one();
+    }
+
+    // Takes the newest job from the thread's own queue, or steals the oldest from another
+    bool Pop(size_t own, Job& job) {
+        for (size_t i = 0; i < queues.size(); i++) {
+            Queue& queue = *queues[(own + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.jobs.empty()) {
+                if (i == 0) {
+                    job = std::move(queue.jobs.back());
+                    queue.jobs.pop_back();
+                }
+                else {
+                    job = std::move(queue.jobs.front());
+                    queue.jobs.pop_front();
+                }
+                queued--;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool PopBackground(Job& job) {
+        std::lock_guard<std::mutex> lock(background.mutex);
+        if (background.jobs.empty()) {
+            return false;
+        }
+
+        job = std::move(background.jobs.front());
+        background.jobs.pop_front();
+        queued--;
+        return true;
+    }
+
+    static void Execute(Job& job) {
+        job.func();
+        if (job.counter != nullptr) {
+            job.counter->pending--;
+        }
+    }
+
+    void WorkerLoop(size_t index) {
+        GetThreadInfo() = {this, index};
+        PROFILE_THREAD_NAME("Job worker " + std::to_string(index));
+
+        while (!stopping) {
+            Job job;
+            if (Pop(index, job) || PopBackground(job)) {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+        }
+    }
+
+public:
+    // Starts the workers. With no workers, jobs run on whichever thread waits for them.
+    explicit JobSystem(unsigned int worker_count) {
+        for (unsigned int i = 0; i <= worker_count; i++) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+
+        for (unsigned int i = 0; i < worker_count; i++) {
+            workers.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    void operator=(const JobSystem&) = delete;
+
+    // Jobs still queued are dropped; the ones already running are finished first
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // The job system everything shares: a worker for every core but the main thread's
+    static JobSystem* GetInstance() {
+        static JobSystem instance(std::max(2u, std::thread::hardware_concurrency()) - 1);
+        return &instance;
+    }
+
+    unsigned int GetWorkerCount() const {
+        return (unsigned int) workers.size();
+    }
+
+    // Starts a job, optionally counted by a counter to Wait() on
+    void Run(std::function<void()> func, JobCounter* counter = nullptr) {
+        if (counter != nullptr) {
+            counter->pending++;
+        }
+
+        Push(*queues[GetOwnQueue()], {std::move(func), counter});
+    }
+
+    // Starts a long job that only the workers will pick up
+    void RunBackground(std::function<void()> func, JobCounter* counter = nullptr) {
+        if (counter != nullptr) {
+            counter->pending++;
+        }
+
+        Push(background, {std::move(func), counter});
+    }
+
+    // Runs other jobs until every job counted by the counter is done
+    void Wait(JobCounter& counter) {
+        PROFILE_SCOPE("Wait for jobs");
+        size_t own = GetOwnQueue();
+
+        while (!counter.IsDone()) {
+            Job job;
+            if (Pop(own, job)) {
+                Execute(job);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Calls func(first, last) over [0, count) in chunks of at least min_chunk,
+    // on every thread at once (this one included), and returns once it's all done
+    template<typename Func>
+    void ParallelFor(size_t count, Func func, size_t min_chunk = 1024) {
+        // A few chunks per thread, so threads that finish early can steal the rest
+        size_t threads = workers.size() + 1;
+        size_t chunk = std::max(min_chunk, (count + threads * 4 - 1) / (threads * 4));
+
+        if (count <= chunk || workers.empty()) {
+            func(size_t(0), count);
+            return;
+        }
+
+        JobCounter counter;
+        for (size_t first = chunk; first < count; first += chunk) {
+            size_t last = std::min(first + chunk, count);
+            Run([&func, first, last] {
+                PROFILE_SCOPE("ParallelFor chunk");
+                func(first, last);
+            }, &counter);
+        }
+
+        {
+            PROFILE_SCOPE("ParallelFor chunk");
+            func(size_t(0), chunk);
+        }
+        Wait(counter);
+    }
+
+    // Calls func with the components of every entity in the view, in parallel.
+    // Only for work where entities don't affect each other.
+    template<typename View, typename Func>
+    void ParallelForEach(View& view, Func func, size_t min_chunk = 1024) {
+        const auto& entities = view.handle();
+
+        ParallelFor(entities.size(), [&view, &entities, &func](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                entt::entity entity = entities.data()[i];
+                if (view.contains(entity)) {
+                    std::apply(func, view.get(entity));
+                }
+            }
+        }, min_chunk);
+    }
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include <raylib.h>
+#include <raymath.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_constants.hpp"
+#include "job_system.hpp"
+
+// Measures how the job system's ParallelForEach scales with the number of threads,
+// on the same position integration the force system does, over a lot of bodies.
+//
+// Usage:
+//   job_system_benchmark [bodies] [passes] [max threads]
+// Defaults to 1000000 bodies, 50 passes and every core.
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Puts every body back where it started, so each thread count does the same work
+void ResetBodies(entt::registry& registry) {
+    int i = 0;
+    for (auto [entity, position, velocity] : registry.view<PositionComponent, VelocityComponent>().each()) {
+        position.position = {float(i % 1000), float(i / 1000)};
+        velocity.velocity = {float(i % 7) - 3.0f, float(i % 5) - 2.0f};
+        i++;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t body_count = argc > 1 ? size_t(std::stoull(argv[1])) : 1000000;
+    int passes = argc > 2 ? std::stoi(argv[2]) : 50;
+    unsigned int max_threads = argc > 3 ? unsigned(std::stoi(argv[3])) : std::max(1u, std::thread::hardware_concurrency());
+
+    entt::registry registry;
+    std::vector<entt::entity> entities(body_count);
+    registry.create(entities.begin(), entities.end());
+    registry.insert<PositionComponent>(entities.begin(), entities.end());
+    registry.insert<VelocityComponent>(entities.begin(), entities.end());
+
+    auto bodies = registry.view<PositionComponent, VelocityComponent>();
+
+    std::cout << body_count << " bodies, " << passes << " passes, " << std::thread::hardware_concurrency() << " cores" << std::endl;
+
+    double single_thread_ms = 0.0;
+    std::vector<Vector2> expected;
+
+    // Powers of two, then the maximum
+    std::vector<unsigned int> thread_counts;
+    for (unsigned int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (unsigned int threads : thread_counts) {
+        // The calling thread works too, so one thread means no workers
+        JobSystem jobs(threads - 1);
+        ResetBodies(registry);
+
+        double best_ms = 0.0;
+        for (int pass = 0; pass < passes; pass++) {
+            auto start = std::chrono::steady_clock::now();
+
+            jobs.ParallelForEach(bodies, [](PositionComponent& position, VelocityComponent& velocity) {
+                position.position = Vector2Add(position.position, Vector2Scale(velocity.velocity, TIMESTEP));
+            });
+
+            double ms = ElapsedMs(start);
+            best_ms = pass == 0 ? ms : std::min(best_ms, ms);
+        }
+
+        // Every thread count has to end up with exactly the same positions
+        std::vector<Vector2> positions;
+        positions.reserve(body_count);
+        for (auto entity : bodies) {
+            positions.push_back(bodies.get<PositionComponent>(entity).position);
+        }
+
+        bool same = true;
+        if (threads == 1) {
+            single_thread_ms = best_ms;
+            expected = positions;
+        }
+        else {
+            same = memcmp(positions.data(), expected.data(), positions.size() * sizeof(Vector2)) == 0;
+        }
+
+        std::cout << threads << " threads: " << best_ms << " ms per pass (best), "
+                  << single_thread_ms / best_ms << "x" << (same ? "" : ", RESULTS DIFFER") << std::endl;
+    }
+
+    return 0;
+}
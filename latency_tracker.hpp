@@ -0,0 +1,127 @@
+#ifndef LATENCY_TRACKER
+#define LATENCY_TRACKER
+
+#include <raylib.h>
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+#include "frame_stats.hpp"
+
+// How long input takes to show up on screen.
+//
+// For a sling release, three moments are timestamped:
+//   polled    raylib reads the input (at the end of EndDrawing). raylib doesn't say
+//             when the event itself arrived, so this is the earliest the game can
+//             know; the real latency is up to a frame longer.
+//   ticked    the first physics tick that sees the release (and flings Siopao)
+//   swapped   EndDrawing returns, having swapped in the frame showing him moving
+//
+// For the sling line, the age of the cursor position it was drawn with, at the swap.
+// Normally that's the position raylib polled at the end of the previous frame. With
+// late latching, the line is drawn last, right before the swap, with the cursor read
+// then (see LatchMousePosition).
+
+#ifdef SIOPAO_LATE_LATCH
+// raylib only updates the cursor position when it polls the input, so late latching
+// asks GLFW (which desktop raylib is built on and links in) directly. The window comes
+// from GLFW too: GetWindowHandle is only a GLFWwindow on Linux (an HWND on Windows,
+// an NSWindow on macOS). Only links against a static raylib; the DLL doesn't export GLFW.
+struct GLFWwindow;
+extern "C" GLFWwindow* glfwGetCurrentContext();
+extern "C" void glfwGetCursorPos(GLFWwindow* window, double* x, double* y);
+#endif
+
+// Whether this build can read the cursor between polls
+inline bool CanLateLatch() {
+#ifdef SIOPAO_LATE_LATCH
+    return true;
+#else
+    return false;
+#endif
+}
+
+// The cursor position right now, not as of the last poll
+inline Vector2 LatchMousePosition() {
+#ifdef SIOPAO_LATE_LATCH
+    double x = 0.0;
+    double y = 0.0;
+    glfwGetCursorPos(glfwGetCurrentContext(), &x, &y);
+    return {float(x), float(y)};
+#else
+    return GetMousePosition();
+#endif
+}
+
+// The last 256 releases (or frames with the sling line) go into the percentiles
+const size_t LATENCY_SAMPLES_SIZE = 256;
+
+class LatencyTracker {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point polled = Clock::now();
+    Clock::time_point latched;
+
+    // A release that was ticked but isn't on screen yet
+    bool release_pending = false;
+    Clock::time_point release_polled;
+    Clock::time_point release_ticked;
+
+    static float GetMs(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<float, std::milli>(to - from).count();
+    }
+
+public:
+    LatencySamples<LATENCY_SAMPLES_SIZE> poll_to_tick;
+    LatencySamples<LATENCY_SAMPLES_SIZE> tick_to_swap;
+    LatencySamples<LATENCY_SAMPLES_SIZE> release_to_swap;
+    LatencySamples<LATENCY_SAMPLES_SIZE> cursor_age;
+
+    // raylib just polled the input
+    void InputPolled() {
+        polled = Clock::now();
+    }
+
+    // A tick just consumed a sling release
+    void ReleaseTicked() {
+        if (!release_pending) {
+            release_pending = true;
+            release_polled = polled;
+            release_ticked = Clock::now();
+        }
+    }
+
+    // The sling line's cursor position was just read with LatchMousePosition
+    void CursorLatched() {
+        latched = Clock::now();
+    }
+
+    // EndDrawing just swapped in a frame. sling_line says whether it had the sling
+    // line on it, and late_latched whether that was drawn with a latched cursor.
+    void Swapped(bool sling_line, bool late_latched) {
+        Clock::time_point now = Clock::now();
+
+        if (release_pending) {
+            poll_to_tick.Add(GetMs(release_polled, release_ticked));
+            tick_to_swap.Add(GetMs(release_ticked, now));
+            release_to_swap.Add(GetMs(release_polled, now));
+            release_pending = false;
+        }
+
+        if (sling_line) {
+            cursor_age.Add(GetMs(late_latched ? latched : polled, now));
+        }
+    }
+};
+
+inline void PrintLatencyStats(LatencyTracker& latency, std::ostream& out) {
+    out << "Sling release to swap (" << latency.release_to_swap.GetCount() << " releases): p50 "
+        << latency.release_to_swap.GetPercentile(0.5f) << " ms, p99 " << latency.release_to_swap.GetPercentile(0.99f)
+        << " ms (poll to tick p50 " << latency.poll_to_tick.GetPercentile(0.5f) << " ms, tick to swap p50 "
+        << latency.tick_to_swap.GetPercentile(0.5f) << " ms)" << std::endl;
+    out << "Sling line cursor age at swap: p50 " << latency.cursor_age.GetPercentile(0.5f) << " ms, p99 "
+        << latency.cursor_age.GetPercentile(0.99f) << " ms" << std::endl;
+}
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef LEVEL
+#define LEVEL
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "binary_file.hpp"
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_constants.hpp"
+#include "game_registry.hpp"
+
+// Levels are loaded from files instead of being hardcoded.
+//
+// Binary format (.lvl), all values little-endian:
+//   LevelFileHeader (which includes the LevelInfo)
+//   LevelPlatform[platform_count]
+//
+// Text format (.txt), for authoring; convert it with level_converter.cpp:
+//   # comments start with a hash
+//   name <name without spaces>
+//   size <width> <height>
+//   spawn <x> <y>
+//   goal <x> <y>
+//   color <r> <g> <b> <a>
+//   platform <x> <y> <width> <height>     (one line per platform)
+
+// Everything about a level besides its platforms.
+// Stored in the registry's context while the level is loaded.
+struct LevelInfo {
+    char name[32] = "Untitled";
+    // Size of the world; falling off the bottom kills Siopao
+    float width = 1280;
+    float height = 720;
+    // Where Siopao starts, and where the steamer basket is
+    Vector2 spawn = {50, 50};
+    Vector2 goal = {1080, 40};
+    Color platform_color = DARKBLUE;
+};
+
+struct LevelPlatform {
+    float x;
+    float y;
+    int32_t width;
+    int32_t height;
+};
+
+const char LEVEL_MAGIC[4] = {'S', 'I', 'O', 'L'};
+const uint32_t LEVEL_VERSION = 1;
+
+struct LevelFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t platform_count;
+    LevelInfo info;
+};
+
+// Platforms are read and created this many at a time, so loading a huge level
+// never needs more than one chunk in memory on top of the registry itself
+const size_t LEVEL_LOAD_CHUNK = 65536;
+
+// Creates Siopao at the level's spawn point (the player's one, or one more for a crowd)
+inline entt::entity CreateSiopao(GameRegistry& registry, const LevelInfo& info) {
+    entt::entity siopao = registry.create();
+    registry.emplace<PositionComponent>(siopao, PositionComponent{info.spawn});
+    registry.emplace<VelocityComponent>(siopao);
+    registry.emplace<CircleColliderComponent>(siopao);
+    registry.emplace<ForceComponent>(siopao);
+    registry.emplace<SlingComponent>(siopao);
+    registry.emplace<AnimationComponent>(siopao, AnimationComponent{{0, 0, playerSize, playerSize}, 0, 0.0f});
+    registry.emplace<ContactComponent>(siopao);
+    return siopao;
+}
+
+// Creates platform entities in bulk: the entities are created with one
+// registry.create(first, last) call and each component with one insert per chunk.
+inline void InsertPlatforms(GameRegistry& registry, const LevelInfo& info, const LevelPlatform* platforms, size_t count,
+                            std::vector<entt::entity>& entities, std::vector<PositionComponent>& positions, std::vector<SizeComponent>& sizes) {
+    entities.resize(count);
+    positions.resize(count);
+    sizes.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        positions[i].position = {platforms[i].x, platforms[i].y};
+        sizes[i] = {platforms[i].width, platforms[i].height};
+    }
+
+    registry.create(entities.begin(), entities.end());
+    registry.insert<PositionComponent>(entities.begin(), entities.end(), positions.begin());
+    registry.insert<ColorComponent>(entities.begin(), entities.end(), ColorComponent{info.platform_color});
+    registry.insert<SizeComponent>(entities.begin(), entities.end(), sizes.begin());
+    registry.insert<PointComponent>(entities.begin(), entities.end(), PointComponent{false});
+}
+
+// Reserves room in every platform storage up front, so inserting doesn't keep reallocating
+inline void ReservePlatforms(GameRegistry& registry, size_t count) {
+    registry.storage<PositionComponent>().reserve(registry.storage<PositionComponent>().size() + count);
+    registry.storage<ColorComponent>().reserve(registry.storage<ColorComponent>().size() + count);
+    registry.storage<SizeComponent>().reserve(registry.storage<SizeComponent>().size() + count);
+    registry.storage<PointComponent>().reserve(registry.storage<PointComponent>().size() + count);
+}
+
+// Creates a level that is already in memory (Siopao first, then the platforms)
+inline void CreateLevelEntities(GameRegistry& registry, const LevelInfo& info, const std::vector<LevelPlatform>& platforms) {
+    registry.ctx().insert_or_assign(info);
+    registry.emplace<PlayerComponent>(CreateSiopao(registry, info));
+
+    ReservePlatforms(registry, platforms.size());
+
+    std::vector<entt::entity> entities;
+    std::vector<PositionComponent> positions;
+    std::vector<SizeComponent> sizes;
+
+    for (size_t first = 0; first < platforms.size(); first += LEVEL_LOAD_CHUNK) {
+        size_t count = std::min(LEVEL_LOAD_CHUNK, platforms.size() - first);
+        InsertPlatforms(registry, info, platforms.data() + first, count, entities, positions, sizes);
+    }
+}
+
+// Also checks the file is big enough for the platforms the header claims
+inline bool ReadLevelHeader(FILE* file, LevelFileHeader& header) {
+    return fread(&header, sizeof(header), 1, file) == 1 &&
+           memcmp(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) == 0 &&
+           header.version == LEVEL_VERSION &&
+           header.platform_count <= UINT64_MAX / sizeof(LevelPlatform) &&
+           HasBytesLeft(file, header.platform_count * sizeof(LevelPlatform));
+}
+
+// Streams a binary level straight into the registry, a chunk at a time.
+// The LevelInfo is also stored in the registry's context.
+// Returns false if the file is missing or invalid.
+inline bool LoadLevel(GameRegistry& registry, const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    LevelFileHeader header;
+    if (!ReadLevelHeader(file, header)) {
+        fclose(file);
+        return false;
+    }
+
+    header.info.name[sizeof(header.info.name) - 1] = '\0';
+    registry.ctx().insert_or_assign(header.info);
+    registry.emplace<PlayerComponent>(CreateSiopao(registry, header.info));
+
+    ReservePlatforms(registry, size_t(header.platform_count));
+
+    std::vector<LevelPlatform> chunk(size_t(std::min<uint64_t>(LEVEL_LOAD_CHUNK, header.platform_count)));
+    std::vector<entt::entity> entities;
+    std::vector<PositionComponent> positions;
+    std::vector<SizeComponent> sizes;
+
+    bool ok = true;
+    for (uint64_t remaining = header.platform_count; remaining > 0 && ok; ) {
+        size_t count = size_t(std::min<uint64_t>(LEVEL_LOAD_CHUNK, remaining));
+        ok = fread(chunk.data(), sizeof(LevelPlatform), count, file) == count;
+
+        if (ok) {
+            InsertPlatforms(registry, header.info, chunk.data(), count, entities, positions, sizes);
+            remaining -= count;
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+// Reads a whole binary level into memory (used by the converter)
+inline bool ReadLevel(const std::string& path, LevelInfo& info, std::vector<LevelPlatform>& platforms) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    LevelFileHeader header;
+    bool ok = ReadLevelHeader(file, header);
+
+    if (ok) {
+        info = header.info;
+        info.name[sizeof(info.name) - 1] = '\0';
+        platforms.resize(size_t(header.platform_count));
+        ok = fread(platforms.data(), sizeof(LevelPlatform), platforms.size(), file) == platforms.size();
+    }
+
+    fclose(file);
+    return ok;
+}
+
+// Writes a binary level. Returns false if it couldn't be written.
+inline bool SaveLevel(const std::string& path, const LevelInfo& info, const std::vector<LevelPlatform>& platforms) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    LevelFileHeader header = {};
+    memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+    header.version = LEVEL_VERSION;
+    header.platform_count = platforms.size();
+    header.info = info;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(platforms.data(), sizeof(LevelPlatform), platforms.size(), file) == platforms.size();
+
+    return fclose(file) == 0 && ok;
+}
+
+// Reads a text level. Returns false (with a message in error) on a bad line.
+inline bool ReadLevelText(const std::string& path, LevelInfo& info, std::vector<LevelPlatform>& platforms, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "could not open " + path;
+        return false;
+    }
+
+    info = LevelInfo();
+    platforms.clear();
+
+    std::string line;
+    for (int line_number = 1; std::getline(file, line); line_number++) {
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+
+        bool ok = true;
+        if (keyword == "name") {
+            std::string name;
+            ok = bool(words >> name);
+            strncpy(info.name, name.c_str(), sizeof(info.name) - 1);
+            info.name[sizeof(info.name) - 1] = '\0';
+        }
+        else if (keyword == "size") {
+            ok = bool(words >> info.width >> info.height);
+        }
+        else if (keyword == "spawn") {
+            ok = bool(words >> info.spawn.x >> info.spawn.y);
+        }
+        else if (keyword == "goal") {
+            ok = bool(words >> info.goal.x >> info.goal.y);
+        }
+        else if (keyword == "color") {
+            int r, g, b, a;
+            ok = bool(words >> r >> g >> b >> a);
+            info.platform_color = {(unsigned char) r, (unsigned char) g, (unsigned char) b, (unsigned char) a};
+        }
+        else if (keyword == "platform") {
+            LevelPlatform platform;
+            ok = bool(words >> platform.x >> platform.y >> platform.width >> platform.height);
+            platforms.push_back(platform);
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = path + ":" + std::to_string(line_number) + ": could not read \"" + line + "\"";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Writes a text level. Returns false if it couldn't be written.
+inline bool SaveLevelText(const std::string& path, const LevelInfo& info, const std::vector<LevelPlatform>& platforms) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    // Enough digits that floats survive the round trip unchanged
+    file.precision(9);
+
+    file << "name " << info.name << "\n";
+    file << "size " << info.width << " " << info.height << "\n";
+    file << "spawn " << info.spawn.x << " " << info.spawn.y << "\n";
+    file << "goal " << info.goal.x << " " << info.goal.y << "\n";
+    file << "color " << int(info.platform_color.r) << " " << int(info.platform_color.g) << " "
+         << int(info.platform_color.b) << " " << int(info.platform_color.a) << "\n";
+
+    for (const LevelPlatform& platform : platforms) {
+        file << "platform " << platform.x << " " << platform.y << " " << platform.width << " " << platform.height << "\n";
+    }
+
+    return bool(file);
+}
+
+#endif
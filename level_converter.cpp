@@ -0,0 +1,47 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "level.hpp"
+
+// Converts levels between the text format (for authoring) and the binary
+// format the game loads (see level.hpp). The direction is picked from the
+// input's extension: .txt is converted to binary, anything else to text.
+//
+// Usage:
+//   level_converter levels/level1.txt levels/level1.lvl
+//   level_converter levels/level1.lvl levels/level1.txt
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cout << "Usage: " << argv[0] << " <input level> <output level>" << std::endl;
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    bool from_text = input.size() >= 4 && input.compare(input.size() - 4, 4, ".txt") == 0;
+
+    LevelInfo info;
+    std::vector<LevelPlatform> platforms;
+
+    if (from_text) {
+        std::string error;
+        if (!ReadLevelText(input, info, platforms, error)) {
+            std::cout << error << std::endl;
+            return 1;
+        }
+    }
+    else if (!ReadLevel(input, info, platforms)) {
+        std::cout << "Could not read " << input << std::endl;
+        return 1;
+    }
+
+    bool ok = from_text ? SaveLevel(output, info, platforms) : SaveLevelText(output, info, platforms);
+    if (!ok) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << "Converted " << info.name << " (" << platforms.size() << " platforms) to " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "level.hpp"
+#include "level_generator.hpp"
+
+// Writes a procedurally generated level (see level_generator.hpp), for trying
+// the game and the headless replay with much bigger levels.
+// Levels ending in .txt are written in the text format, anything else in binary.
+//
+// Usage:
+//   level_generator <seed> <platform count> <output level>
+//   level_generator 1 1000000 levels/generated_1m.lvl
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        std::cout << "Usage: " << argv[0] << " <seed> <platform count> <output level>" << std::endl;
+        return 1;
+    }
+
+    uint32_t seed = uint32_t(std::stoul(argv[1]));
+    size_t platform_count = size_t(std::stoull(argv[2]));
+    std::string output = argv[3];
+
+    LevelInfo info;
+    std::vector<LevelPlatform> platforms;
+
+    auto start = std::chrono::steady_clock::now();
+    GenerateLevel(seed, platform_count, info, platforms);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool text = output.size() >= 4 && output.compare(output.size() - 4, 4, ".txt") == 0;
+    bool ok = text ? SaveLevelText(output, info, platforms) : SaveLevel(output, info, platforms);
+    if (!ok) {
+        std::cout << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << "Generated " << info.name << ": " << platforms.size() << " platforms, "
+              << info.width << " x " << info.height << " in " << seconds << " s" << std::endl;
+    return 0;
+}
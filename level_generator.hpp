@@ -0,0 +1,175 @@
+#ifndef LEVEL_GENERATOR
+#define LEVEL_GENERATOR
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "game_constants.hpp"
+#include "level.hpp"
+
+// Procedural levels, for testing how things scale with far more platforms
+// than a hand-made level has. The same seed and size always give the same level.
+//
+// The platforms form one path from a landing pad at the bottom left to the
+// steamer basket at the top, snaking left and right in rows that climb upward.
+// Every platform is within jumping distance of the one before it, worked out
+// from a simulated full-power sling with the physics constants the game uses.
+
+// How far Siopao can get with a full-power sling (both axes at max velocity)
+class JumpLimits {
+    // Siopao's offset from the launch point after every tick in the air (y is up)
+    std::vector<Vector2> arc;
+
+public:
+    JumpLimits() {
+        // Same steps as the airborne part of PhysicsTick
+        Vector2 position = {0, 0};
+        Vector2 velocity = {playerMaxHorizontalVelocity, -playerMaxVerticalVelocity};
+
+        // Follow the arc down to well below the launch point
+        while (position.y > -4 * playerMaxVerticalVelocity) {
+            position.x += velocity.x * TIMESTEP;
+            position.y -= velocity.y * TIMESTEP;
+            arc.push_back(position);
+
+            velocity.y += gravity * TIMESTEP * 2;
+            velocity.x -= velocity.x * drag * TIMESTEP * 2;
+            velocity.y = std::min(velocity.y, playerMaxVerticalVelocity);
+        }
+    }
+
+    // The highest Siopao gets above where he jumped from
+    float GetMaxRise() const {
+        float rise = 0;
+        for (const Vector2& point : arc) {
+            rise = std::max(rise, point.y);
+        }
+
+        return rise;
+    }
+
+    // How far sideways Siopao gets by the time he comes back down to the specified
+    // height (negative for below where he jumped from), or 0 if he can't get that high
+    float GetReach(float rise) const {
+        float reach = 0;
+        for (size_t i = 1; i < arc.size(); i++) {
+            // Falling through the height
+            if (arc[i - 1].y >= rise && arc[i].y < rise) {
+                reach = arc[i - 1].x;
+            }
+        }
+
+        return reach;
+    }
+};
+
+// Fraction of the jump limits actually used, so every jump has room for error
+const float LEVEL_GENERATOR_SAFETY = 0.6f;
+
+const int GENERATED_PLATFORM_HEIGHT = 25;
+const int GENERATED_PLATFORM_MIN_WIDTH = 60;
+const int GENERATED_PLATFORM_MAX_WIDTH = 200;
+
+// Space left around the path, and above the top platform for the spawn point and HUD
+const float GENERATED_LEVEL_MARGIN = 100;
+const float GENERATED_LEVEL_TOP_MARGIN = 200;
+
+// Same random numbers on every compiler (std::uniform_real_distribution isn't)
+inline float RandomFloat(std::mt19937& rng, float min, float max) {
+    return min + (max - min) * (float(rng() >> 8) / 16777216.0f);
+}
+
+// Generates a level with the specified number of platforms (at least 2).
+// Rows are about as wide as the level is tall, so huge levels stay within a range
+// where float positions are still precise.
+inline void GenerateLevel(uint32_t seed, size_t platform_count, LevelInfo& info, std::vector<LevelPlatform>& platforms) {
+    std::mt19937 rng(seed);
+    JumpLimits limits;
+
+    float max_rise = limits.GetMaxRise() * LEVEL_GENERATOR_SAFETY;
+    // Rows are far enough apart that a jump never reaches the row above by accident
+    float row_spacing = limits.GetMaxRise() * 1.2f;
+    size_t per_row = std::max<size_t>(6, size_t(std::sqrt(2.0 * double(platform_count))));
+
+    platform_count = std::max<size_t>(platform_count, 2);
+    platforms.clear();
+    platforms.reserve(platform_count);
+
+    // Start on a wide landing pad, like the hand-made level
+    platforms.push_back({0, 0, 150, GENERATED_PLATFORM_HEIGHT});
+
+    int direction = 1;
+    size_t row = 0;
+    size_t in_row = 1;
+
+    while (platforms.size() < platform_count) {
+        const LevelPlatform& last = platforms.back();
+        LevelPlatform next;
+        next.height = GENERATED_PLATFORM_HEIGHT;
+        next.width = int32_t(RandomFloat(rng, GENERATED_PLATFORM_MIN_WIDTH, GENERATED_PLATFORM_MAX_WIDTH + 1));
+
+        float row_y = -float(row) * row_spacing;
+
+        if (in_row < per_row) {
+            // Along the row: wander up and down a little around the row's height
+            float target_y = row_y + RandomFloat(rng, -0.3f, 0.3f) * max_rise;
+            float rise = std::clamp(last.y - target_y, -max_rise, max_rise);
+            float gap = RandomFloat(rng, 0.15f, 1.0f) * limits.GetReach(rise) * LEVEL_GENERATOR_SAFETY;
+
+            next.y = last.y - rise;
+            next.x = direction > 0 ? last.x + last.width + gap : last.x - gap - next.width;
+            in_row++;
+        }
+        else {
+            // End of the row: climb straight up to the next one, then turn around
+            float rise = std::min(max_rise, last.y - (row_y - row_spacing));
+
+            next.y = last.y - rise;
+            next.x = last.x + RandomFloat(rng, -0.5f, 0.5f) * last.width;
+
+            if (next.y <= row_y - row_spacing) {
+                row++;
+                in_row = 1;
+                direction = -direction;
+            }
+        }
+
+        platforms.push_back(next);
+    }
+
+    // Move everything so the level starts at (0, 0), with margins around the path
+    float min_x = platforms[0].x, max_x = platforms[0].x + platforms[0].width;
+    float min_y = platforms[0].y, max_y = platforms[0].y + platforms[0].height;
+    for (const LevelPlatform& platform : platforms) {
+        min_x = std::min(min_x, platform.x);
+        max_x = std::max(max_x, platform.x + platform.width);
+        min_y = std::min(min_y, platform.y);
+        max_y = std::max(max_y, platform.y + platform.height);
+    }
+
+    float offset_x = GENERATED_LEVEL_MARGIN - min_x;
+    float offset_y = GENERATED_LEVEL_TOP_MARGIN - min_y;
+    for (LevelPlatform& platform : platforms) {
+        platform.x += offset_x;
+        platform.y += offset_y;
+    }
+
+    info = LevelInfo();
+    snprintf(info.name, sizeof(info.name), "Generated_%u_%zu", seed, platform_count);
+    info.width = std::max(max_x - min_x + 2 * GENERATED_LEVEL_MARGIN, 1280.0f);
+    info.height = std::max(max_y - min_y + GENERATED_LEVEL_TOP_MARGIN + GENERATED_LEVEL_MARGIN, 720.0f);
+
+    // Drop onto the landing pad, and finish by standing on the last platform
+    const LevelPlatform& first = platforms.front();
+    const LevelPlatform& last = platforms.back();
+    info.spawn = {first.x + 10, std::max(first.y - 150, 0.0f)};
+    info.goal = {last.x + last.width / 2.0f - 32, last.y - 58};
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef MEMORY_REPORT
+#define MEMORY_REPORT
+
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_registry.hpp"
+
+// How much memory every component storage of the registry takes, to find the
+// ones worth shrinking on big levels.
+//
+// A storage is three arrays:
+//   sparse    entity -> index, allocated in pages of ENTT_SPARSE_PAGE entities. Only the
+//             pages its entities fall in are allocated, but the list of page pointers
+//             goes as far as the highest entity it ever held
+//   dense     the entities that have the component, one after another
+//   payload   the components, allocated in pages of ENTT_PACKED_PAGE components
+// "Used" counts only the bytes holding entities and components; "reserved" is what's
+// actually allocated, unused capacity and partly filled pages included.
+
+struct StorageMemory {
+    std::string_view name;
+    size_t entities = 0;
+
+    size_t sparse_used = 0;
+    size_t sparse_reserved = 0;
+    size_t dense_used = 0;
+    size_t dense_reserved = 0;
+    size_t payload_used = 0;
+    size_t payload_reserved = 0;
+
+    // False for component types the report doesn't know the size of (their payload isn't counted)
+    bool known_size = true;
+
+    size_t GetUsed() const {
+        return sparse_used + dense_used + payload_used;
+    }
+
+    size_t GetReserved() const {
+        return sparse_reserved + dense_reserved + payload_reserved;
+    }
+};
+
+struct MemoryReport {
+    std::vector<StorageMemory> storages;
+
+    // The registry's own list of entities
+    size_t entities = 0;
+    size_t entities_used = 0;
+    size_t entities_reserved = 0;
+
+    // What the level's arena holds, storages and everything else the registry allocated
+    size_t arena_used = 0;
+    size_t arena_reserved = 0;
+
+    // Which sparse pages the storage being counted uses, kept so updates don't allocate
+    std::vector<bool> sparse_pages_used;
+
+    size_t GetUsed() const {
+        size_t used = entities_used;
+        for (const StorageMemory& storage : storages) {
+            used += storage.GetUsed();
+        }
+        return used;
+    }
+
+    size_t GetReserved() const {
+        size_t reserved = entities_reserved;
+        for (const StorageMemory& storage : storages) {
+            reserved += storage.GetReserved();
+        }
+        return reserved;
+    }
+};
+
+// Size of one component, for the types the game uses (the storages don't say).
+// Tags like PlayerComponent have no payload at all, so they're size 0.
+// Returns false for anything else.
+template<typename... Type>
+bool GetComponentSize(entt::id_type id, size_t& size) {
+    return ((id == entt::type_hash<Type>::value() ? (size = std::is_empty_v<Type> ? 0 : sizeof(Type), true) : false) || ...);
+}
+
+inline bool GetGameComponentSize(entt::id_type id, size_t& size) {
+    return GetComponentSize<PositionComponent, SizeComponent, ColorComponent, VelocityComponent,
+                            CircleColliderComponent, ForceComponent, PointComponent, SlingComponent,
+                            AnimationComponent, ContactComponent, PlayerComponent>(id, size);
+}
+
+// Fills the report in for the registry as it is now.
+// The report's vector is reused, so calling this every frame doesn't allocate.
+inline void UpdateMemoryReport(const GameRegistry& registry, MemoryReport& report) {
+    using Base = entt::basic_sparse_set<entt::entity, ArenaAllocator<entt::entity>>;
+
+    report.storages.clear();
+
+    for (auto [id, storage] : registry.storage()) {
+        StorageMemory memory;
+        memory.name = storage.type().name();
+        memory.entities = storage.size();
+
+        // The sparse array is a list of pages, each allocated whole the first time an
+        // entity in it gets the component (and kept after it loses it, which isn't counted)
+        size_t page_count = storage.extent() / ENTT_SPARSE_PAGE;
+        report.sparse_pages_used.assign(page_count, false);
+        size_t sparse_pages = 0;
+        for (entt::entity entity : storage) {
+            size_t page = size_t(entt::to_entity(entity)) / ENTT_SPARSE_PAGE;
+            if (page < page_count && !report.sparse_pages_used[page]) {
+                report.sparse_pages_used[page] = true;
+                sparse_pages++;
+            }
+        }
+
+        memory.sparse_used = storage.size() * sizeof(entt::entity);
+        memory.sparse_reserved = sparse_pages * ENTT_SPARSE_PAGE * sizeof(entt::entity) + page_count * sizeof(void*);
+
+        // The storage overrides capacity() with the payload's, so ask the sparse set itself
+        memory.dense_used = storage.size() * sizeof(entt::entity);
+        memory.dense_reserved = storage.Base::capacity() * sizeof(entt::entity);
+
+        size_t component_size = 0;
+        memory.known_size = GetGameComponentSize(id, component_size);
+        if (memory.known_size && component_size > 0) {
+            size_t payload_pages = storage.capacity() / ENTT_PACKED_PAGE;
+            memory.payload_used = storage.size() * component_size;
+            memory.payload_reserved = storage.capacity() * component_size + payload_pages * sizeof(void*);
+        }
+
+        report.storages.push_back(memory);
+    }
+
+    report.entities = registry.alive();
+    report.entities_used = registry.size() * sizeof(entt::entity);
+    report.entities_reserved = registry.capacity() * sizeof(entt::entity);
+
+    const Arena* arena = registry.get_allocator().GetArena();
+    report.arena_used = arena != nullptr ? arena->GetBytesUsed() : 0;
+    report.arena_reserved = arena != nullptr ? arena->GetBytesReserved() : 0;
+}
+
+// Prints the report as a table, one storage per line
+inline void PrintMemoryReport(const MemoryReport& report, std::ostream& out) {
+    out << std::left << std::setw(28) << "Storage" << std::right
+        << std::setw(10) << "Entities" << std::setw(12) << "Used" << std::setw(12) << "Reserved"
+        << std::setw(12) << "Sparse" << std::setw(12) << "Dense" << std::setw(12) << "Payload" << "\n";
+
+    for (const StorageMemory& storage : report.storages) {
+        out << std::left << std::setw(28) << storage.name << std::right
+            << std::setw(10) << storage.entities << std::setw(12) << storage.GetUsed() << std::setw(12) << storage.GetReserved()
+            << std::setw(12) << storage.sparse_reserved << std::setw(12) << storage.dense_reserved;
+        if (storage.known_size) {
+            out << std::setw(12) << storage.payload_reserved << "\n";
+        }
+        else {
+            out << std::setw(12) << "?" << "\n";
+        }
+    }
+
+    out << std::left << std::setw(28) << "(entities)" << std::right
+        << std::setw(10) << report.entities << std::setw(12) << report.entities_used << std::setw(12) << report.entities_reserved << "\n";
+    out << "Total: " << report.GetUsed() << " bytes used, " << report.GetReserved() << " reserved"
+        << " (arena: " << report.arena_used << " handed out, " << report.arena_reserved << " reserved)\n";
+}
+
+#endif
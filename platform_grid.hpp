@@ -0,0 +1,170 @@
+#ifndef PLATFORM_GRID
+#define PLATFORM_GRID
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_registry.hpp"
+
+// Broadphase for the platforms: a grid of cells, each listing the platforms
+// overlapping it, so collisions (and drawing) only look at platforms near
+// something instead of at every platform in the level.
+//
+// The grid is kept up to date with an entt::observer that collects every
+// platform whose position or size was created or changed, so the update only
+// costs as much as what changed, not the size of the level. That only works if
+// platforms are changed with registry.patch / replace / emplace_or_replace
+// (like the rewind buffer does), never through a reference from a view.
+// Platforms that are destroyed stay in their cells; queries skip them.
+
+const float PLATFORM_GRID_CELL_SIZE = 256.0f;
+
+class PlatformGrid {
+    // The cells a platform is in, from (min_x, min_y) to (max_x, max_y)
+    struct CellRange {
+        int32_t min_x, min_y, max_x, max_y;
+    };
+
+    std::unordered_map<uint64_t, std::vector<entt::entity>> cells;
+    entt::storage<CellRange> placed;
+
+    // Platforms added or changed since the last Update
+    std::unique_ptr<entt::basic_observer<GameRegistry>> changes;
+
+    static int32_t GetCell(float coordinate) {
+        return int32_t(std::floor(coordinate / PLATFORM_GRID_CELL_SIZE));
+    }
+
+    static uint64_t GetKey(int32_t x, int32_t y) {
+        return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    }
+
+    static CellRange GetRange(Rectangle area) {
+        return {GetCell(area.x), GetCell(area.y), GetCell(area.x + area.width), GetCell(area.y + area.height)};
+    }
+
+    static bool IsSameRange(const CellRange& range, const PositionComponent& position, const SizeComponent& size) {
+        CellRange now = GetRange({position.position.x, position.position.y, float(size.width), float(size.height)});
+        return now.min_x == range.min_x && now.min_y == range.min_y && now.max_x == range.max_x && now.max_y == range.max_y;
+    }
+
+    void Insert(entt::entity entity, const PositionComponent& position, const SizeComponent& size) {
+        CellRange range = GetRange({position.position.x, position.position.y, float(size.width), float(size.height)});
+        for (int32_t y = range.min_y; y <= range.max_y; y++) {
+            for (int32_t x = range.min_x; x <= range.max_x; x++) {
+                cells[GetKey(x, y)].push_back(entity);
+            }
+        }
+        placed.emplace(entity, range);
+    }
+
+    void Remove(entt::entity entity) {
+        if (!placed.contains(entity)) {
+            return;
+        }
+
+        CellRange range = placed.get(entity);
+        for (int32_t y = range.min_y; y <= range.max_y; y++) {
+            for (int32_t x = range.min_x; x <= range.max_x; x++) {
+                std::vector<entt::entity>& cell = cells[GetKey(x, y)];
+                auto it = std::find(cell.begin(), cell.end(), entity);
+                if (it != cell.end()) {
+                    *it = cell.back();
+                    cell.pop_back();
+                }
+            }
+        }
+        placed.erase(entity);
+    }
+
+public:
+    // Starts watching the registry's platforms, and adds the ones it already has.
+    // Only once per registry: the observer can't be disconnected safely, so it has
+    // to live as long as the registry does (in its context).
+    void Connect(GameRegistry& registry) {
+        changes = std::make_unique<entt::basic_observer<GameRegistry>>(registry, entt::collector
+            .group<PositionComponent, SizeComponent>()
+            .update<PositionComponent>().where<SizeComponent>()
+            .update<SizeComponent>().where<PositionComponent>());
+
+        for (auto [entity, position, size] : registry.view<const PositionComponent, const SizeComponent>().each()) {
+            Insert(entity, position, size);
+        }
+    }
+
+    bool IsConnected() const {
+        return changes != nullptr;
+    }
+
+    // Moves the platforms that changed since the last update into their new cells
+    template<typename View>
+    void Update(const View& platforms) {
+        if (changes == nullptr) {
+            return;
+        }
+
+        // The observer's own iterators don't match a registry with a custom allocator, so go through its data
+        for (size_t i = 0; i < changes->size(); i++) {
+            entt::entity entity = changes->data()[i];
+            if (!platforms.contains(entity)) {
+                Remove(entity);
+                continue;
+            }
+
+            // A LoadWorld (like every respawn) reports the whole level as changed, but
+            // it mostly puts platforms back where they already were, so those stay put
+            const PositionComponent& position = platforms.template get<const PositionComponent>(entity);
+            const SizeComponent& size = platforms.template get<const SizeComponent>(entity);
+            if (placed.contains(entity) && IsSameRange(placed.get(entity), position, size)) {
+                continue;
+            }
+            Remove(entity);
+            Insert(entity, position, size);
+        }
+        changes->clear();
+    }
+
+    // How many platforms changed since the last update
+    size_t GetPendingChanges() const {
+        return changes != nullptr ? changes->size() : 0;
+    }
+
+    // Puts every platform of the view overlapping the area's cells into candidates,
+    // once each, newest first (by entity, so the order doesn't depend on how the
+    // storages happen to be sorted). Those are only the ones that could touch the
+    // area; the caller still has to check.
+    template<typename View>
+    void Query(Rectangle area, const View& platforms, std::vector<entt::entity>& candidates) const {
+        candidates.clear();
+
+        CellRange range = GetRange(area);
+        for (int32_t y = range.min_y; y <= range.max_y; y++) {
+            for (int32_t x = range.min_x; x <= range.max_x; x++) {
+                auto cell = cells.find(GetKey(x, y));
+                if (cell == cells.end()) {
+                    continue;
+                }
+                for (entt::entity entity : cell->second) {
+                    if (platforms.contains(entity)) {
+                        candidates.push_back(entity);
+                    }
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](entt::entity a, entt::entity b) {
+            return entt::to_integral(a) > entt::to_integral(b);
+        });
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+};
+
+#endif
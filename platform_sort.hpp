@@ -0,0 +1,125 @@
+#ifndef PLATFORM_SORT
+#define PLATFORM_SORT
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_registry.hpp"
+
+// Keeps the platform storages in Z-order (Morton order) of their positions.
+// Levels are created in whatever order the file lists the platforms in, so two
+// platforms next to each other can end up far apart in memory; in Z-order,
+// platforms close together in the level are mostly close together in the
+// storages too, so looking at a neighbourhood (like the grid queries do) touches
+// a few runs of memory instead of bits from all over.
+//
+// Siopao and the --bodies crowd share the position storage with the platforms.
+// They aren't sorted in with them: they all get the last key, so they stay
+// together at one end and the body systems still go through them in one run.
+
+// The key of everything without a size (the bodies), after every platform's
+const uint64_t NOT_A_PLATFORM_KEY = UINT64_MAX;
+
+// After this many changed platforms a full radix sort is cheaper than fixing the order up
+const size_t PLATFORM_RESORT_LIMIT = 16;
+
+// Spreads the bits of value out over the even bits of the result
+inline uint64_t SpreadBits(uint32_t value) {
+    uint64_t bits = value;
+    bits = (bits | (bits << 16)) & 0x0000FFFF0000FFFFull;
+    bits = (bits | (bits << 8)) & 0x00FF00FF00FF00FFull;
+    bits = (bits | (bits << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    bits = (bits | (bits << 2)) & 0x3333333333333333ull;
+    bits = (bits | (bits << 1)) & 0x5555555555555555ull;
+    return bits;
+}
+
+// Whole pixels, shifted so negative coordinates still come before positive ones
+inline uint32_t GetMortonCoordinate(float coordinate) {
+    double pixel = std::clamp(std::floor(double(coordinate)), -2147483648.0, 2147483647.0);
+    return uint32_t(int64_t(pixel) + 2147483648ll);
+}
+
+// The position's place along the Z-order curve: x and y's bits interleaved
+inline uint64_t GetMortonKey(Vector2 position) {
+    return SpreadBits(GetMortonCoordinate(position.x)) | (SpreadBits(GetMortonCoordinate(position.y)) << 1);
+}
+
+// The key a position is sorted by: the Morton key for platforms, NOT_A_PLATFORM_KEY for bodies
+inline uint64_t GetSortKey(const GameRegistry& registry, entt::entity entity) {
+    if (!registry.all_of<SizeComponent>(entity)) {
+        return NOT_A_PLATFORM_KEY;
+    }
+
+    return GetMortonKey(registry.get<PositionComponent>(entity).position);
+}
+
+// Puts the other platform storages in the same order as the positions
+inline void MatchPlatformOrder(GameRegistry& registry) {
+    registry.sort<SizeComponent, PositionComponent>();
+    registry.sort<ColorComponent, PositionComponent>();
+    registry.sort<PointComponent, PositionComponent>();
+}
+
+// Sorts the positions with entt's radix sort on the sort key, then puts the
+// other platform storages in the same order
+inline void SortPlatforms(GameRegistry& registry) {
+    // The radix sort is stable, so sorting by entity first breaks ties (all the bodies) by entity
+    registry.sort<PositionComponent>([](entt::entity entity) {
+        return entt::to_integral(entity);
+    }, entt::radix_sort<8, 32>{});
+
+    registry.sort<PositionComponent>([&registry](entt::entity entity) {
+        return GetSortKey(registry, entity);
+    }, entt::radix_sort<8, 64>{});
+
+    MatchPlatformOrder(registry);
+}
+
+// Whether the platforms' positions are still in Z-order (the bodies moving doesn't matter)
+inline bool IsInMortonOrder(GameRegistry& registry) {
+    auto& sizes = registry.storage<SizeComponent>();
+
+    uint64_t previous = 0;
+    for (auto [entity, position] : registry.storage<PositionComponent>().each()) {
+        if (!sizes.contains(entity)) {
+            continue;
+        }
+
+        uint64_t key = GetMortonKey(position.position);
+        if (key < previous) {
+            return false;
+        }
+        previous = key;
+    }
+    return true;
+}
+
+// Re-sorts after some platforms changed. A few changes leave the storages almost
+// sorted, which insertion sort fixes in about one pass; lots of changes get the
+// full radix sort, unless they're still in order. Restoring a saved world
+// (respawning) changes every platform but keeps the order they were saved in.
+inline void ResortPlatforms(GameRegistry& registry, size_t changed) {
+    if (changed > PLATFORM_RESORT_LIMIT) {
+        if (!IsInMortonOrder(registry)) {
+            SortPlatforms(registry);
+        }
+        return;
+    }
+
+    registry.sort<PositionComponent>([&registry](entt::entity a, entt::entity b) {
+        uint64_t key_a = GetSortKey(registry, a);
+        uint64_t key_b = GetSortKey(registry, b);
+        return key_a != key_b ? key_a < key_b : a < b;
+    }, entt::insertion_sort{});
+
+    MatchPlatformOrder(registry);
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef PROFILER
+#define PROFILER
+
+#include <string>
+
+// Scoped timers for finding out where a frame's time goes.
+//
+// Put PROFILE_SCOPE("name") at the top of a block to time it. Every thread
+// records into its own buffer, so recording never takes a lock; the buffers are
+// written out as Chrome trace-event JSON by WriteChromeTrace(), which can be
+// opened in chrome://tracing or https://ui.perfetto.dev.
+//
+// Only compiled in when SIOPAO_PROFILE is defined (e.g. -DSIOPAO_PROFILE).
+// Otherwise PROFILE_SCOPE expands to nothing and nothing is recorded.
+// Names must be string literals (or otherwise outlive the program), since only
+// the pointer is stored.
+
+#ifdef SIOPAO_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Events kept per thread; once a thread's buffer is full, its later events are dropped
+const size_t PROFILE_EVENTS_PER_THREAD = 1 << 18;
+
+struct ProfileEvent {
+    const char* name;
+    int64_t start;
+    int64_t duration;
+};
+
+// One thread's events. Only the owning thread writes; count is published after
+// each event is written, so WriteChromeTrace can read up to it at any time.
+struct ProfileBuffer {
+    std::unique_ptr<ProfileEvent[]> events{new ProfileEvent[PROFILE_EVENTS_PER_THREAD]};
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+    uint32_t thread_id = 0;
+    std::string thread_name;
+};
+
+class Profiler {
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+    // Guards the list of buffers and the thread names, not the events
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfileBuffer>> buffers;
+
+    Profiler() {}
+
+    ProfileBuffer& GetThreadBuffer() {
+        static thread_local ProfileBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(std::make_unique<ProfileBuffer>());
+            buffer = buffers.back().get();
+            buffer->thread_id = uint32_t(buffers.size());
+            buffer->thread_name = "Thread " + std::to_string(buffer->thread_id);
+        }
+
+        return *buffer;
+    }
+
+public:
+    // Never destroyed, so threads still running while the program exits can keep recording
+    static Profiler* GetInstance() {
+        static Profiler* instance = new Profiler();
+        return instance;
+    }
+
+    // Nanoseconds since the profiler started
+    int64_t Now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    void Record(const char* name, int64_t start, int64_t end) {
+        ProfileBuffer& buffer = GetThreadBuffer();
+        size_t index = buffer.count.load(std::memory_order_relaxed);
+
+        if (index >= PROFILE_EVENTS_PER_THREAD) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.events[index] = {name, start, end - start};
+        buffer.count.store(index + 1, std::memory_order_release);
+    }
+
+    // Names the calling thread in the trace
+    void SetThreadName(const std::string& name) {
+        ProfileBuffer& buffer = GetThreadBuffer();
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer.thread_name = name;
+    }
+
+    // Writes every event recorded so far. Returns false if the file couldn't be written.
+    bool WriteChromeTrace(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        bool first = true;
+        size_t dropped = 0;
+        for (const std::unique_ptr<ProfileBuffer>& buffer : buffers) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", buffer->thread_id, buffer->thread_name.c_str());
+            first = false;
+
+            // Timestamps are in microseconds
+            size_t count = buffer->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                const ProfileEvent& event = buffer->events[i];
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                        event.name, buffer->thread_id, event.start / 1000.0, event.duration / 1000.0);
+            }
+
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+
+        fprintf(file, "\n],\"otherData\":{\"dropped_events\":%zu}}\n", dropped);
+        return fclose(file) == 0;
+    }
+};
+
+// Records the time between its construction and destruction
+class ProfileScope {
+    const char* name;
+    int64_t start;
+
+public:
+    explicit ProfileScope(const char* name) : name(name), start(Profiler::GetInstance()->Now()) {}
+
+    ProfileScope(const ProfileScope&) = delete;
+    void operator=(const ProfileScope&) = delete;
+
+    ~ProfileScope() {
+        Profiler::GetInstance()->Record(name, start, Profiler::GetInstance()->Now());
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Profiler::GetInstance()->SetThreadName(name)
+
+inline bool WriteChromeTrace(const std::string& path) {
+    return Profiler::GetInstance()->WriteChromeTrace(path);
+}
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD_NAME(name)
+
+// Nothing is recorded without SIOPAO_PROFILE
+inline bool WriteChromeTrace(const std::string&) {
+    return false;
+}
+
+#endif
+
+#endif
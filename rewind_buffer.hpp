@@ -0,0 +1,317 @@
+#ifndef REWIND_BUFFER
+#define REWIND_BUFFER
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_registry.hpp"
+#include "world_snapshot.hpp"
+
+// Keeps the last few seconds of world state so it can be rewound.
+//
+// Instead of a full copy of the world every tick, each tick only records the
+// components that changed since the tick before (a delta), with a full copy
+// (a keyframe) every keyframe_interval ticks. Seeking to a tick means applying
+// the keyframe before it and then the deltas up to it, so it never touches
+// more than keyframe_interval records.
+//
+// Ticks are stored in a ring buffer, so memory is bounded by the capacity
+// and each slot's buffer is reused once it has grown to size.
+// Only the listed component types are tracked, and entities are expected to
+// keep the same components while they're being recorded (true for our levels).
+//
+// Most of a level never changes, so only what can change is looked at every tick:
+// - the bodies (anything with a Moving component), which the systems change
+//   through views without telling anyone, so they're compared every tick
+// - anything else whose component was added, patched or replaced since the last
+//   tick, collected by an entt::observer (a platform being scored, or everything
+//   at once after a LoadWorld)
+// A "full copy" is the bodies plus whatever else changed at least once since
+// recording started, so keyframes don't grow with the level either.
+// Records a single registry for its whole life, which has to outlive it.
+template<typename Moving, typename... Component>
+class BasicRewindBuffer {
+    struct TickRecord {
+        // Per component: a count, followed by that many (entity, component) pairs
+        std::vector<unsigned char> data;
+        bool keyframe = false;
+    };
+
+    // An entity other than a body that changed: what it was before, and when it first changed
+    template<typename Type>
+    struct Changed {
+        Type before;
+        uint64_t tick;
+    };
+
+    template<typename Type>
+    struct Tracked {
+        // Every entity's component as of newest_tick, used to find what changed
+        entt::storage<Type> previous;
+        // Everything besides the bodies that changed since recording started
+        entt::storage<Changed<Type>> changed;
+        // What was added, patched or replaced since the last tick
+        std::unique_ptr<entt::basic_observer<GameRegistry>> changes;
+    };
+
+    std::vector<TickRecord> records;
+    uint32_t keyframe_interval;
+
+    // The range of ticks currently held
+    bool empty = true;
+    uint64_t oldest_tick = 0;
+    uint64_t newest_tick = 0;
+
+    std::tuple<Tracked<Component>...> tracked;
+
+    TickRecord& GetRecord(uint64_t tick) {
+        return records[tick % records.size()];
+    }
+
+    template<typename Type>
+    void RecordComponent(GameRegistry& registry, TickRecord& record, uint64_t tick) {
+        const auto& storage = registry.storage<Type>();
+        auto bodies = registry.view<const Moving>();
+        Tracked<Type>& state = std::get<Tracked<Type>>(tracked);
+        SnapshotOutputArchive archive(record.data);
+
+        size_t count_offset = record.data.size();
+        uint32_t count = 0;
+        archive(count);
+
+        if (state.changes == nullptr) {
+            state.changes = std::make_unique<entt::basic_observer<GameRegistry>>(registry, entt::collector.template group<Type>().template update<Type>());
+        }
+
+        if (empty) {
+            // Starting over: the only time every entity is copied
+            state.previous.clear();
+            state.changed.clear();
+            state.changes->clear();
+            for (auto [entity, value] : storage.each()) {
+                state.previous.emplace(entity, value);
+            }
+        }
+
+        // The bodies, every tick
+        for (entt::entity entity : bodies) {
+            if (!storage.contains(entity)) {
+                continue;
+            }
+
+            const Type& value = storage.get(entity);
+            if (!state.previous.contains(entity)) {
+                state.previous.emplace(entity, value);
+            }
+            else if (record.keyframe || memcmp(&state.previous.get(entity), &value, sizeof(Type)) != 0) {
+                state.previous.get(entity) = value;
+            }
+            else {
+                // Unchanged since the last tick
+                continue;
+            }
+
+            archive(entity, value);
+            count++;
+        }
+
+        // Everything else that was written to since the last tick.
+        // The observer's own iterators don't match a registry with a custom allocator, so go through its data.
+        for (size_t i = 0; i < state.changes->size(); i++) {
+            entt::entity entity = state.changes->data()[i];
+            if (bodies.contains(entity) || !storage.contains(entity)) {
+                continue;
+            }
+
+            const Type& value = storage.get(entity);
+            if (!state.previous.contains(entity)) {
+                // New since recording started, so there's nothing to go back to
+                state.previous.emplace(entity, value);
+                state.changed.emplace(entity, Changed<Type>{value, 0});
+            }
+            else if (memcmp(&state.previous.get(entity), &value, sizeof(Type)) != 0) {
+                if (!state.changed.contains(entity)) {
+                    state.changed.emplace(entity, Changed<Type>{state.previous.get(entity), tick});
+                }
+                state.previous.get(entity) = value;
+            }
+            else {
+                continue;
+            }
+
+            // Keyframes write every changed entity below anyway
+            if (!record.keyframe) {
+                archive(entity, value);
+                count++;
+            }
+        }
+        state.changes->clear();
+
+        if (record.keyframe) {
+            for (auto [entity, changed] : state.changed.each()) {
+                archive(entity, state.previous.get(entity));
+                count++;
+            }
+        }
+
+        memcpy(record.data.data() + count_offset, &count, sizeof(count));
+    }
+
+    // Writes the component only if it actually differs, so a keyframe doesn't look
+    // like everything changed to whoever watches for changes (the platform grid)
+    template<typename Type>
+    void Write(GameRegistry& registry, entt::entity entity, const Type& value) {
+        Tracked<Type>& state = std::get<Tracked<Type>>(tracked);
+
+        Type* current = registry.try_get<Type>(entity);
+        if (current == nullptr || memcmp(current, &value, sizeof(Type)) != 0) {
+            registry.emplace_or_replace<Type>(entity, value);
+        }
+
+        if (state.previous.contains(entity)) {
+            state.previous.get(entity) = value;
+        }
+        else {
+            state.previous.emplace(entity, value);
+        }
+    }
+
+    template<typename Type>
+    void ApplyComponent(GameRegistry& registry, SnapshotInputArchive& archive) {
+        uint32_t count = 0;
+        archive(count);
+
+        entt::entity entity;
+        Type value;
+        for (uint32_t i = 0; i < count; i++) {
+            archive(entity, value);
+            if (registry.valid(entity)) {
+                Write(registry, entity, value);
+            }
+        }
+    }
+
+    void Apply(GameRegistry& registry, const TickRecord& record) {
+        SnapshotInputArchive archive(record.data);
+        (ApplyComponent<Component>(registry, archive), ...);
+    }
+
+    // Puts back whatever first changed after the keyframe, which the keyframe doesn't
+    // have, to how it was before. Anything that first changed after the tick being
+    // rewound to is no longer a change at all.
+    template<typename Type>
+    void RestoreComponent(GameRegistry& registry, uint64_t keyframe, uint64_t tick) {
+        Tracked<Type>& state = std::get<Tracked<Type>>(tracked);
+
+        for (auto [entity, changed] : state.changed.each()) {
+            if (changed.tick > keyframe && registry.valid(entity)) {
+                Write(registry, entity, changed.before);
+            }
+        }
+
+        // Backwards, so erasing doesn't move what's still to be checked
+        for (size_t i = state.changed.size(); i > 0; i--) {
+            entt::entity entity = state.changed.data()[i - 1];
+            if (state.changed.get(entity).tick > tick) {
+                state.changed.erase(entity);
+            }
+        }
+    }
+
+public:
+    // capacity is the number of ticks kept (e.g. 10 seconds at 60 ticks per second is 600)
+    BasicRewindBuffer(uint32_t capacity, uint32_t keyframe_interval)
+        : records(capacity), keyframe_interval(keyframe_interval) {}
+
+    // Records the state of the world after a tick
+    void Record(GameRegistry& registry) {
+        uint64_t tick = empty ? 0 : newest_tick + 1;
+
+        TickRecord& record = GetRecord(tick);
+        record.data.clear();
+        record.keyframe = empty || tick % keyframe_interval == 0;
+
+        (RecordComponent<Component>(registry, record, tick), ...);
+
+        newest_tick = tick;
+        if (empty) {
+            oldest_tick = tick;
+            empty = false;
+        }
+        else if (newest_tick - oldest_tick + 1 > records.size()) {
+            // The ring buffer wrapped around and overwrote the oldest tick
+            oldest_tick++;
+        }
+    }
+
+    // Gets the oldest tick that can still be rewound to.
+    // That's the first keyframe in the buffer, since older deltas have lost theirs.
+    uint64_t GetOldestTick() {
+        uint64_t tick = oldest_tick;
+        while (tick < newest_tick && !GetRecord(tick).keyframe) {
+            tick++;
+        }
+
+        return tick;
+    }
+
+    uint64_t GetNewestTick() const {
+        return newest_tick;
+    }
+
+    bool CanRewind() {
+        return !empty && GetOldestTick() < newest_tick;
+    }
+
+    // Puts the world back to how it was at the specified tick, and forgets every
+    // tick after it (recording continues from there).
+    // Returns false if the tick is no longer (or not yet) in the buffer.
+    bool RewindTo(GameRegistry& registry, uint64_t tick) {
+        if (empty || tick < GetOldestTick() || tick > newest_tick) {
+            return false;
+        }
+
+        uint64_t keyframe = tick;
+        while (!GetRecord(keyframe).keyframe) {
+            keyframe--;
+        }
+
+        (RestoreComponent<Component>(registry, keyframe, tick), ...);
+        for (uint64_t i = keyframe; i <= tick; i++) {
+            Apply(registry, GetRecord(i));
+        }
+
+        newest_tick = tick;
+        return true;
+    }
+
+    // Forgets every recorded tick
+    void Clear() {
+        empty = true;
+        oldest_tick = 0;
+        newest_tick = 0;
+    }
+
+    // Bytes currently held by the recorded ticks (including unused capacity)
+    size_t GetMemoryUsage() const {
+        size_t bytes = 0;
+        for (const TickRecord& record : records) {
+            bytes += record.data.capacity();
+        }
+
+        return bytes;
+    }
+};
+
+// The components that change while playing (ForceComponent and ContactComponent
+// are worked out again every tick before they're used, so they're left out).
+// The bodies are everything with a velocity.
+using RewindBuffer = BasicRewindBuffer<VelocityComponent, PositionComponent, VelocityComponent, CircleColliderComponent, PointComponent,
+                                       SlingComponent, AnimationComponent>;
+
+#endif
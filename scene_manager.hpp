@@ -4,8 +4,374 @@
 #include <raylib.h>
 
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "asset_pack.hpp"
+#include "entt.hpp"
+#include "job_system.hpp"
+
+// A texture owned by the resource manager.
+// While an asynchronous load is in flight, texture holds the placeholder.
+struct TextureSlot {
+    Texture texture;
+    bool ready = false;
+    // Number of TextureHandles alive for this texture (the cache's own reference isn't one)
+    int handles = 0;
+};
+
+// Reference-counted handle to a texture owned by the resource manager.
+// Always safe to draw with: it yields a placeholder until the real texture is uploaded.
+// A texture stays resident for as long as at least one handle to it is alive.
+class TextureHandle {
+    entt::resource<TextureSlot> slot;
+
+    void Acquire() {
+        if (slot) {
+            slot->handles++;
+        }
+    }
+
+    void Release() {
+        if (slot) {
+            slot->handles--;
+        }
+    }
+
+public:
+    TextureHandle() {}
+    explicit TextureHandle(entt::resource<TextureSlot> slot) : slot(std::move(slot)) {
+        Acquire();
+    }
+
+    TextureHandle(const TextureHandle& other) : slot(other.slot) {
+        Acquire();
+    }
+
+    TextureHandle& operator=(const TextureHandle& other) {
+        if (this != &other) {
+            Release();
+            slot = other.slot;
+            Acquire();
+        }
+        return *this;
+    }
+
+    ~TextureHandle() {
+        Release();
+    }
+
+    // Gets the texture to draw this frame (the placeholder if it's still loading,
+    // or if the handle is empty)
+    Texture Get() const;
+
+    bool IsReady() const {
+        return slot && slot->ready;
+    }
+};
+
+// Things the resource manager can report about its textures
+enum class ResourceEvent {
+    LoadedFromDisk,
+    LoadedFromPack,
+    AlreadyLoaded,
+    QueuedAsync,
+    UploadedAsync,
+    Reloaded,
+    Released
+};
+
+struct ResourceLogEntry {
+    ResourceEvent event;
+    entt::id_type id;
+    // Only filled in when the texture is loaded, so cache hits don't allocate
+    std::string path;
+};
+
+// Resource manager implemented as a singleton
+class ResourceManager {
+    // Textures keyed by the hash of their path. The cache holds one reference
+    // to each texture, handed out to the rest of the game as TextureHandles.
+    entt::resource_cache<TextureSlot> textures;
+
+    // Shown in place of textures that are still being decoded
+    Texture placeholder = {};
+
+    // Pre-decoded textures, checked before going to disk (see MountAssetPack)
+    AssetPack asset_pack;
+
+    // Uploads a texture straight from the mounted asset pack, with no decoding.
+    // Returns false if there is no pack or it doesn't have this texture.
+    bool LoadFromAssetPack(entt::id_type id, Texture& texture) {
+        Image image;
+        if (!asset_pack.IsOpen() || !asset_pack.GetImage(id, image)) {
+            return false;
+        }
+
+        // The image points into the pack, so it's not unloaded afterwards
+        texture = LoadTextureFromImage(image);
+        return true;
+    }
+
+    // An image decoded by a worker, waiting for its GPU upload on the main thread
+    struct DecodedImage {
+        entt::id_type id;
+        Image image;
+        // Replaces an already uploaded texture instead of a placeholder
+        bool reload;
+    };
+
+    std::vector<DecodedImage> decoded_images;
+    std::mutex decoded_mutex;
+
+    // Optional log of resource events. Recording an entry only appends to this buffer;
+    // nothing is written to the console until FlushLog() is called.
+    // All events are recorded on the main thread, so no locking is needed.
+    bool logging_enabled = false;
+    std::vector<ResourceLogEntry> log;
+
+    void Log(ResourceEvent event, entt::id_type id, const char* path = nullptr) {
+        if (logging_enabled) {
+            log.push_back({event, id, path != nullptr ? path : ""});
+        }
+    }
+
+    // Decode jobs still running; waited for before anything they touch is destroyed
+    JobCounter decode_jobs;
+
+    // Decodes an image on a worker thread and queues it for UploadPendingTextures()
+    void DecodeAsync(entt::id_type id, std::string path, bool reload) {
+        JobSystem::GetInstance()->RunBackground([this, id, path = std::move(path), reload] {
+            PROFILE_SCOPE("Decode image");
+            Image image = LoadImage(path.c_str());
+
+            std::lock_guard<std::mutex> lock(decoded_mutex);
+            decoded_images.push_back({id, image, reload});
+        }, &decode_jobs);
+    }
+
+    // The job system is created first, so it's still there when this is destroyed
+    ResourceManager() {
+        JobSystem::GetInstance();
+    }
+
+    ~ResourceManager() {
+        JobSystem::GetInstance()->Wait(decode_jobs);
+
+        for (DecodedImage& decoded : decoded_images) {
+            UnloadImage(decoded.image);
+        }
+    }
+
+public:
+    // Delete copy constructor and copy operator (=)
+    // Ensures there will only be one instance of the resource manager
+    ResourceManager(const ResourceManager&) = delete;
+    void operator=(const ResourceManager&) = delete;
+
+    static ResourceManager* GetInstance() {
+        static ResourceManager insance;
+        return &insance;
+    }
+
+    // The checkerboard drawn in place of a texture that isn't there (yet)
+    Texture GetPlaceholder() {
+        if (placeholder.id == 0) {
+            Image image = GenImageChecked(16, 16, 8, 8, MAGENTA, BLACK);
+            placeholder = LoadTextureFromImage(image);
+            UnloadImage(image);
+        }
+
+        return placeholder;
+    }
+
+    // Gets a texture, loading it from disk if it isn't resident yet.
+    // The path is hashed once (at compile time for string literals), and a cache
+    // hit costs a single lookup, so this is cheap enough to call every frame.
+    // Pass literal paths as "path"_hs, and runtime ones as entt::hashed_string{path.c_str()}.
+    TextureHandle GetTexture(entt::hashed_string path) {
+        auto [it, inserted] = textures.load(path.value());
+        TextureSlot& slot = *it->second;
+
+        // If the texture does not exist yet in our records (or is still being decoded
+        // in the background), load it now and store it in memory.
+        if (!slot.ready) {
+            if (LoadFromAssetPack(path.value(), slot.texture)) {
+                Log(ResourceEvent::LoadedFromPack, path.value(), path.data());
+            }
+            else {
+                Log(ResourceEvent::LoadedFromDisk, path.value(), path.data());
+                slot.texture = LoadTexture(path.data());
+            }
+
+            slot.ready = true;
+        }
+        else {
+            Log(ResourceEvent::AlreadyLoaded, path.value());
+        }
+
+        return TextureHandle(it->second);
+    }
+
+    // Starts loading a texture without blocking the calling thread.
+    // The image is decoded on a worker thread; only the GPU upload is left for the
+    // main thread, done by UploadPendingTextures().
+    TextureHandle GetTextureAsync(entt::hashed_string path) {
+        auto [it, inserted] = textures.load(path.value());
+        if (!inserted) {
+            Log(ResourceEvent::AlreadyLoaded, path.value());
+            return TextureHandle(it->second);
+        }
+
+        // Textures in the asset pack need no decoding, so there's nothing to wait for
+        if (LoadFromAssetPack(path.value(), it->second->texture)) {
+            Log(ResourceEvent::LoadedFromPack, path.value(), path.data());
+            it->second->ready = true;
+            return TextureHandle(it->second);
+        }
+
+        Log(ResourceEvent::QueuedAsync, path.value(), path.data());
+        it->second->texture = GetPlaceholder();
+
+        // The hashed_string may point at a temporary, so the worker gets its own copy
+        DecodeAsync(path.value(), path.data(), false);
+
+        return TextureHandle(it->second);
+    }
+
+    // Re-decodes a texture from disk in the background, e.g. after an artist saved it.
+    // Once uploaded, the new texture replaces the old one in place, so every handle
+    // to it picks up the change. Unlike the rest of the manager, this may be called
+    // from any thread; textures that aren't loaded are simply skipped at upload.
+    void ReloadTextureAsync(const std::string& path) {
+        DecodeAsync(entt::hashed_string{path.c_str()}, path, true);
+    }
+
+    // Uploads the images decoded since the last call to the GPU.
+    // Must be called from the main thread, once per frame. Since this runs between
+    // frames, reloaded textures are never swapped in the middle of drawing.
+    // Returns whether any texture was uploaded or replaced.
+    bool UploadPendingTextures() {
+        std::vector<DecodedImage> uploads;
+        {
+            std::lock_guard<std::mutex> lock(decoded_mutex);
+            uploads.swap(decoded_images);
+        }
+
+        bool changed = false;
+        for (DecodedImage& decoded : uploads) {
+            entt::resource<TextureSlot> slot = textures[decoded.id];
+
+            if (!slot || decoded.image.data == nullptr) {
+                // Released in the meantime, or the file couldn't be read
+                // (e.g. an editor was still writing it)
+            }
+            else if (!slot->ready) {
+                Log(ResourceEvent::UploadedAsync, decoded.id);
+                slot->texture = LoadTextureFromImage(decoded.image);
+                slot->ready = true;
+                changed = true;
+            }
+            else if (decoded.reload) {
+                Log(ResourceEvent::Reloaded, decoded.id);
+                UnloadTexture(slot->texture);
+                slot->texture = LoadTextureFromImage(decoded.image);
+                changed = true;
+            }
+
+            UnloadImage(decoded.image);
+        }
+        return changed;
+    }
+
+    // Unloads every texture that nobody but the cache holds a handle to anymore.
+    // Called by the scene manager after a scene switch, so memory use follows
+    // the working set of the active scene.
+    void ReleaseUnusedTextures() {
+        std::vector<entt::id_type> unused;
+
+        for (auto [id, slot] : textures) {
+            if (slot->handles == 0) {
+                unused.push_back(id);
+            }
+        }
+
+        for (entt::id_type id : unused) {
+            TextureSlot& slot = *textures[id];
+            if (slot.ready) {
+                UnloadTexture(slot.texture);
+            }
+
+            Log(ResourceEvent::Released, id);
+            textures.erase(id);
+        }
+    }
+
+    // Mounts an asset pack made by asset_packer. From then on, textures found in it are
+    // uploaded straight from the (memory-mapped) pack instead of being decoded from disk.
+    // Returns false if the pack is missing or invalid, in which case files are used as before.
+    bool MountAssetPack(const std::string& path) {
+        return asset_pack.Open(path);
+    }
+
+    // Turns the resource event log on or off (off by default)
+    void SetLogging(bool enabled) {
+        logging_enabled = enabled;
+        if (!enabled) {
+            log.clear();
+        }
+    }
+
+    // Writes out and clears the events recorded since the last flush.
+    // Call this wherever a console write is acceptable, e.g. between frames.
+    void FlushLog() {
+        if (log.empty()) {
+            return;
+        }
+
+        for (const ResourceLogEntry& entry : log) {
+            switch (entry.event) {
+                case ResourceEvent::LoadedFromDisk: std::cout << "Loaded " << entry.path << " from Disk\n"; break;
+                case ResourceEvent::LoadedFromPack: std::cout << "Loaded " << entry.path << " from Asset Pack\n"; break;
+                case ResourceEvent::AlreadyLoaded: std::cout << "Resource " << entry.id << " Already Loaded\n"; break;
+                case ResourceEvent::QueuedAsync: std::cout << "Loading " << entry.path << " in the background\n"; break;
+                case ResourceEvent::UploadedAsync: std::cout << "Uploaded texture " << entry.id << "\n"; break;
+                case ResourceEvent::Reloaded: std::cout << "Reloaded texture " << entry.id << "\n"; break;
+                case ResourceEvent::Released: std::cout << "Released texture " << entry.id << "\n"; break;
+            }
+        }
+
+        std::cout.flush();
+        log.clear();
+    }
+
+    // Used for unloading all the textures when the game is closed.
+    void UnloadAllTextures() {
+        for (auto [id, slot] : textures) {
+            if (slot->ready) {
+                UnloadTexture(slot->texture);
+            }
+        }
+
+        textures.clear();
+
+        if (placeholder.id != 0) {
+            UnloadTexture(placeholder);
+            placeholder = {};
+        }
+    }
+};
+
+inline Texture TextureHandle::Get() const {
+    if (!slot) {
+        return ResourceManager::GetInstance()->GetPlaceholder();
+    }
+    return slot->texture;
+}
 
 class SceneManager;
 
@@ -15,11 +381,27 @@ class Scene {
     // In practice, you would want to make this private (or protected)
     // and set this via the constructor.
     SceneManager* scene_manager;
+
+    // Textures requested by Prefetch(), kept resident until the scene begins
+    std::vector<TextureHandle> prefetched_textures;
+
+protected:
+    // Starts loading a texture in the background on behalf of Prefetch()
+    void PrefetchTexture(entt::hashed_string path) {
+        prefetched_textures.push_back(ResourceManager::GetInstance()->GetTextureAsync(path));
+    }
+
 public:
+    // Starts loading the scene's resources in the background without beginning it.
+    // Override this and call PrefetchTexture for each texture Begin() will ask for;
+    // Begin() then finds them already resident.
+    virtual void Prefetch() {}
+
     // Begins the scene. This is where you can load resources
     virtual void Begin() = 0;
 
     // Ends the scene. This is where you can unload resources
+    // (dropping a TextureHandle is enough for the resource manager to release it)
     virtual void End() = 0;
 
     // Updates scene's state (physics, input, etc. can be added here)
@@ -28,6 +410,18 @@ public:
     // Draws the scene's current state
     virtual void Draw() = 0;
 
+    // Called when another scene is pushed on top of this one.
+    // Unlike End(), the scene keeps its resources and state.
+    virtual void Suspend() {}
+
+    // Called when the scene on top of this one is popped
+    virtual void Resume() {}
+
+    // Overlays (e.g. a pause menu) let the scene below keep drawing underneath them
+    virtual bool IsOverlay() const {
+        return false;
+    }
+
     void SetSceneManager(SceneManager* scene_manager) {
         this->scene_manager = scene_manager;
     }
@@ -35,6 +429,27 @@ public:
     SceneManager* GetSceneManager() {
         return scene_manager;
     }
+
+    // Fraction (from 0 to 1) of the prefetched resources that are ready to use
+    float GetPrefetchProgress() const {
+        if (prefetched_textures.empty()) {
+            return 1.0f;
+        }
+
+        int ready = 0;
+        for (const TextureHandle& texture : prefetched_textures) {
+            if (texture.IsReady()) {
+                ready++;
+            }
+        }
+
+        return float(ready) / float(prefetched_textures.size());
+    }
+
+    // Drops the scene's hold on its prefetched resources
+    void ClearPrefetched() {
+        prefetched_textures.clear();
+    }
 };
 
 
@@ -42,8 +457,21 @@ class SceneManager {
     // Mapping between a scene ID and a reference to the scene
     std::unordered_map<int, Scene*> scenes;
 
-     // Current active scene
-    Scene* active_scene = nullptr;
+    // Stack of running scenes. The top one is the active scene;
+    // the ones below it are suspended, not ended.
+    std::vector<Scene*> scene_stack;
+
+    // Begins a scene and lets go of whatever is no longer needed afterwards
+    void BeginScene(Scene* scene) {
+        scene->Begin();
+
+        // Begin() holds its own handles now, so the prefetched ones can go
+        scene->ClearPrefetched();
+
+        // Only release textures after the new scene has begun, so the ones it
+        // shares with the previous scene stay resident instead of being reloaded
+        ResourceManager::GetInstance()->ReleaseUnusedTextures();
+    }
 
 public:
     // Adds the specified scene to the scene manager, and assigns it
@@ -58,7 +486,36 @@ public:
         scenes.erase(scene_id);
     }
 
+    // Starts loading the resources of the scene identified by the specified scene ID
+    // in the background, while the current scene keeps running.
+    // Once GetPrefetchProgress reaches 1, switching to that scene is instant.
+    void PrefetchScene(int scene_id) {
+        if (scenes.find(scene_id) == scenes.end()) {
+            std::cout << "Scene ID not found" << std::endl;
+            return;
+        }
+
+        Scene* scene = scenes[scene_id];
+        scene->ClearPrefetched();
+        scene->Prefetch();
+    }
+
+    // Gets how far along (from 0 to 1) the prefetch of the specified scene is,
+    // e.g. for drawing a loading bar
+    float GetPrefetchProgress(int scene_id) {
+        if (scenes.find(scene_id) == scenes.end()) {
+            return 0.0f;
+        }
+
+        return scenes[scene_id]->GetPrefetchProgress();
+    }
+
+    bool IsPrefetchComplete(int scene_id) {
+        return GetPrefetchProgress(scene_id) >= 1.0f;
+    }
+
     // Switches to the scene identified by the specified scene ID.
+    // If the scene was prefetched, its resources are already resident and Begin() won't block.
     void SwitchScene(int scene_id) {
         // If the scene ID does not exist in our records,
         // don't do anything (or you can print an error message).
@@ -67,62 +524,94 @@ public:
             return;
         }
 
-        // If there is already an active scene, end it first
-        if (active_scene != nullptr) {
-            active_scene->End();
+        // End every running scene first, including suspended ones
+        while (!scene_stack.empty()) {
+            scene_stack.back()->End();
+            scene_stack.pop_back();
         }
 
         std::cout << "Moved to Scene " << scene_id << std::endl;
 
-        active_scene = scenes[scene_id];
+        scene_stack.push_back(scenes[scene_id]);
 
-        active_scene->Begin();
+        BeginScene(scene_stack.back());
     }
 
-    // Gets the active scene
-    Scene* GetActiveScene() {
-        return active_scene;
+    // Pushes the scene identified by the specified scene ID on top of the active scene.
+    // The active scene is suspended rather than ended, so it keeps its resources and
+    // state, and resumes where it left off when the pushed scene is popped.
+    void PushScene(int scene_id) {
+        if (scenes.find(scene_id) == scenes.end()) {
+            std::cout << "Scene ID not found" << std::endl;
+            return;
+        }
+
+        Scene* scene = scenes[scene_id];
+        for (Scene* running : scene_stack) {
+            if (running == scene) {
+                std::cout << "Scene " << scene_id << " is already running" << std::endl;
+                return;
+            }
+        }
+
+        if (!scene_stack.empty()) {
+            scene_stack.back()->Suspend();
+        }
+
+        std::cout << "Pushed Scene " << scene_id << std::endl;
+
+        scene_stack.push_back(scene);
+
+        BeginScene(scene);
     }
-};
 
-// Resource manager implemented as a singleton
-class ResourceManager {
-    std::unordered_map<std::string, Texture> textures;
+    // Ends the active scene and resumes the one below it
+    void PopScene() {
+        if (scene_stack.empty()) {
+            return;
+        }
 
-    ResourceManager() {}
+        scene_stack.back()->End();
+        scene_stack.pop_back();
 
-public:
-    // Delete copy constructor and copy operator (=)
-    // Ensures there will only be one instance of the resource manager
-    ResourceManager(const ResourceManager&) = delete;
-    void operator=(const ResourceManager&) = delete;
+        ResourceManager::GetInstance()->ReleaseUnusedTextures();
 
-    static ResourceManager* GetInstance() {
-        static ResourceManager insance;
-        return &insance;
+        if (!scene_stack.empty()) {
+            scene_stack.back()->Resume();
+        }
     }
 
-    Texture GetTexture(const std::string& path) {
-        // If the texture does not exist yet in our records,
-        // load it and store it in memory.
-        if (textures.find(path) == textures.end()) {
-            std::cout << "Loaded " << path << " from Disk" << std::endl;
-            textures[path] = LoadTexture(path.c_str());
+    // Updates the active scene. Suspended scenes are not updated.
+    void Update() {
+        if (!scene_stack.empty()) {
+            scene_stack.back()->Update();
         }
-        else {
-            std::cout << "Resource Already Loaded" << std::endl;
+    }
+
+    // Draws the active scene, along with the scenes below it
+    // for as long as the scenes on top are overlays
+    void Draw() {
+        if (scene_stack.empty()) {
+            return;
         }
 
-        return textures[path];
+        size_t bottom = scene_stack.size() - 1;
+        while (bottom > 0 && scene_stack[bottom]->IsOverlay()) {
+            bottom--;
+        }
+
+        for (size_t i = bottom; i < scene_stack.size(); i++) {
+            scene_stack[i]->Draw();
+        }
     }
 
-    // Used for unloading all the textures when the game is closed.
-    void UnloadAllTextures() {
-        for (auto it : textures) {
-            UnloadTexture(it.second);
+    // Gets the active scene
+    Scene* GetActiveScene() {
+        if (scene_stack.empty()) {
+            return nullptr;
         }
 
-        textures.clear();
+        return scene_stack.back();
     }
 };
 
@@ -131,14 +620,28 @@ public:
 // Ideally, you would have a separate file where you will define the scenes,
 // and keep this file purely as a scene and resource manager.
 class TitleScene : public Scene {
-    Texture raylib_logo;
+    TextureHandle raylib_logo;
 
 public:
+    // Texture paths known at compile time are hashed with _hs, so the hashing happens then too
+    void Prefetch() override {
+        using namespace entt::literals;
+        PrefetchTexture("Raylib_logo.png"_hs);
+    }
+
     void Begin() override {
-        raylib_logo = ResourceManager::GetInstance()->GetTexture("Raylib_logo.png");
+        using namespace entt::literals;
+        raylib_logo = ResourceManager::GetInstance()->GetTextureAsync("Raylib_logo.png"_hs);
+
+        // Start loading the game scene while the player is still on the title screen
+        if (GetSceneManager() != nullptr) {
+            GetSceneManager()->PrefetchScene(1);
+        }
     }
 
-    void End() override {}
+    void End() override {
+        raylib_logo = TextureHandle();
+    }
 
     void Update() override {
         if (IsKeyPressed(KEY_ENTER)) {
@@ -149,25 +652,40 @@ public:
     }
 
     void Draw() override {
-        DrawTexturePro(raylib_logo, {0, 0, 256, 256}, {300, 100, 200, 200}, {0, 0}, 0.0f, WHITE);
+        DrawTexturePro(raylib_logo.Get(), {0, 0, 256, 256}, {300, 100, 200, 200}, {0, 0}, 0.0f, WHITE);
         DrawText("Press ENTER", 300, 325, 30, BLACK);
+
+        // Loading bar for the game scene
+        if (GetSceneManager() != nullptr && !GetSceneManager()->IsPrefetchComplete(1)) {
+            float progress = GetSceneManager()->GetPrefetchProgress(1);
+            DrawRectangleLines(300, 370, 200, 10, DARKGRAY);
+            DrawRectangle(300, 370, int(200 * progress), 10, DARKGRAY);
+        }
     }
 };
 
 
 class GameScene : public Scene {
-    Texture raylib_logo;
+    TextureHandle raylib_logo;
     Vector2 logo_position;
     float move_dir_x = 1;
     float move_dir_y = 1;
 
 public:
+    void Prefetch() override {
+        using namespace entt::literals;
+        PrefetchTexture("Raylib_logo.png"_hs);
+    }
+
     void Begin() override {
-        raylib_logo = ResourceManager::GetInstance()->GetTexture("Raylib_logo.png");
+        using namespace entt::literals;
+        raylib_logo = ResourceManager::GetInstance()->GetTextureAsync("Raylib_logo.png"_hs);
         logo_position = {300, 100};
     }   
 
-    void End() override {}
+    void End() override {
+        raylib_logo = TextureHandle();
+    }
 
     void Update() override {
         float delta_time = GetFrameTime();
@@ -181,10 +699,43 @@ public:
         if (logo_position.y + 200 >= 600 || logo_position.y <= 0) {
             move_dir_y *= -1;
         }
+
+        // Opening the pause menu suspends this scene instead of ending it,
+        // so logo_position is kept and nothing gets reloaded
+        if (IsKeyPressed(KEY_P)) {
+            if (GetSceneManager() != nullptr) {
+                GetSceneManager()->PushScene(2);
+            }
+        }
     }
 
     void Draw() override {
-        DrawTexturePro(raylib_logo, {0, 0, 256, 256}, {logo_position.x, logo_position.y, 200, 200}, {0, 0}, 0.0f, WHITE);
+        DrawTexturePro(raylib_logo.Get(), {0, 0, 256, 256}, {logo_position.x, logo_position.y, 200, 200}, {0, 0}, 0.0f, WHITE);
+    }
+};
+
+// Pause menu drawn on top of the game scene
+class PauseScene : public Scene {
+public:
+    void Begin() override {}
+
+    void End() override {}
+
+    void Update() override {
+        if (IsKeyPressed(KEY_P)) {
+            if (GetSceneManager() != nullptr) {
+                GetSceneManager()->PopScene();
+            }
+        }
+    }
+
+    void Draw() override {
+        DrawRectangle(0, 0, 800, 600, Fade(BLACK, 0.5f));
+        DrawText("Paused", 340, 275, 30, WHITE);
+    }
+
+    bool IsOverlay() const override {
+        return true;
     }
 };
 
@@ -0,0 +1,143 @@
+#ifndef SYSTEM_SCHEDULER
+#define SYSTEM_SCHEDULER
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+#include "entt.hpp"
+#include "game_registry.hpp"
+#include "job_system.hpp"
+#include "profiler.hpp"
+
+// Runs systems registered with an entt::organizer (GameOrganizer, for the game's registry).
+//
+// A system is a free function whose parameters say what it uses:
+//   GameView<const A, B>    reads A, writes B
+//   const Type& / Type&     reads / writes a variable in the registry's context
+//   GameRegistry&           anything at all (runs on its own)
+// The organizer turns that into a dependency graph: systems that write something
+// another one uses run in the order they were added, the rest can run at the same time.
+// So the results are the same whether the graph runs in parallel or one system at a time.
+
+// Which job system systems may split their own work over (see ParallelEach).
+// Kept in the registry's context; without one everything runs on the calling thread.
+struct SystemThreads {
+    JobSystem* jobs = nullptr;
+};
+
+// Calls func with the components of every entity in the view, split over the
+// job system. Only for work where entities don't affect each other.
+template<typename View, typename Func>
+void ParallelEach(const SystemThreads& threads, View& view, Func func) {
+    if (threads.jobs != nullptr) {
+        threads.jobs->ParallelForEach(view, func);
+        return;
+    }
+
+    for (auto entity : view) {
+        std::apply(func, view.get(entity));
+    }
+}
+
+class SystemScheduler {
+    GameOrganizer organizer;
+    std::vector<GameOrganizer::vertex> graph;
+
+    // How many systems each system waits for
+    std::vector<size_t> dependency_counts;
+    std::unique_ptr<std::atomic<size_t>[]> waiting_for;
+
+    JobSystem* jobs;
+
+    void RunSystem(GameRegistry& registry, size_t index, JobCounter& counter) {
+        const GameOrganizer::vertex& system = graph[index];
+        {
+            PROFILE_SCOPE(system.name());
+            system.callback()(system.data(), registry);
+        }
+
+        // Start whatever was only waiting for this one
+        for (size_t child : system.children()) {
+            if (--waiting_for[child] == 0) {
+                jobs->Run([this, &registry, child, &counter] { RunSystem(registry, child, counter); }, &counter);
+            }
+        }
+    }
+
+public:
+    // Systems run as jobs, or one after another on the calling thread without a job system
+    explicit SystemScheduler(JobSystem* jobs) : jobs(jobs) {}
+
+    SystemScheduler(const SystemScheduler&) = delete;
+    void operator=(const SystemScheduler&) = delete;
+
+    // Adds a system. Systems that use the same data run in the order they're added.
+    template<auto System>
+    void Add(const char* name) {
+        organizer.emplace<System>(name);
+    }
+
+    // Works out the graph once every system is added. Also creates every storage
+    // and context variable the systems use, so running them never has to.
+    void Build(GameRegistry& registry) {
+        graph = organizer.graph();
+        dependency_counts.assign(graph.size(), 0);
+        waiting_for = std::make_unique<std::atomic<size_t>[]>(graph.size());
+
+        registry.ctx().emplace<SystemThreads>();
+        for (const GameOrganizer::vertex& system : graph) {
+            system.prepare(registry);
+            for (size_t child : system.children()) {
+                dependency_counts[child]++;
+            }
+        }
+    }
+
+    // Runs every system once, and returns once they're all done.
+    // The calling thread runs systems too while it waits.
+    void Run(GameRegistry& registry) {
+        registry.ctx().get<SystemThreads>().jobs = jobs;
+
+        if (jobs == nullptr) {
+            // The graph is in the order the systems were added, which is always a valid order
+            for (const GameOrganizer::vertex& system : graph) {
+                PROFILE_SCOPE(system.name());
+                system.callback()(system.data(), registry);
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < graph.size(); i++) {
+            waiting_for[i] = dependency_counts[i];
+        }
+
+        JobCounter counter;
+        for (size_t i = 0; i < graph.size(); i++) {
+            if (graph[i].top_level()) {
+                jobs->Run([this, &registry, i, &counter] { RunSystem(registry, i, counter); }, &counter);
+            }
+        }
+
+        jobs->Wait(counter);
+    }
+
+    // Lists every system and the ones that have to wait for it
+    void PrintGraph(std::ostream& out) const {
+        for (const GameOrganizer::vertex& system : graph) {
+            out << system.name() << " (reads " << system.ro_count() << ", writes " << system.rw_count() << ")";
+            if (!system.children().empty()) {
+                out << " ->";
+                for (size_t child : system.children()) {
+                    out << " " << graph[child].name();
+                }
+            }
+            out << "\n";
+        }
+    }
+};
+
+#endif
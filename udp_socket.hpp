@@ -0,0 +1,174 @@
+#ifndef UDP_SOCKET
+#define UDP_SOCKET
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// A non-blocking UDP socket talking to one peer on this machine (127.0.0.1),
+// for ghost racing between two copies of the game.
+//
+// Loopback never loses or delays anything, so the socket can pretend to be a
+// worse network: outgoing packets are held back for delay_ms and dropped with a
+// probability of loss, which is what the rollback has to cope with over a real one.
+// Only implemented with POSIX sockets (Linux and macOS); elsewhere Open fails.
+
+struct NetConditions {
+    float delay_ms = 0.0f;
+    // 0 to 1
+    float loss = 0.0f;
+};
+
+class UdpSocket {
+    using Clock = std::chrono::steady_clock;
+
+    struct DelayedPacket {
+        Clock::time_point due;
+        std::vector<unsigned char> data;
+    };
+
+    int fd = -1;
+    uint16_t peer_port = 0;
+
+    NetConditions conditions;
+    std::deque<DelayedPacket> outgoing;
+    // Fixed seed, so a run with loss drops the same packets every time
+    std::mt19937 random{12345};
+
+    size_t sent = 0;
+    size_t dropped = 0;
+    size_t received = 0;
+
+    void SendNow(const std::vector<unsigned char>& data) {
+#if defined(__unix__) || defined(__APPLE__)
+        sockaddr_in peer = {};
+        peer.sin_family = AF_INET;
+        peer.sin_port = htons(peer_port);
+        peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sendto(fd, data.data(), data.size(), 0, reinterpret_cast<sockaddr*>(&peer), sizeof(peer));
+#endif
+    }
+
+public:
+    UdpSocket() {}
+
+    UdpSocket(const UdpSocket&) = delete;
+    void operator=(const UdpSocket&) = delete;
+
+    ~UdpSocket() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    // Listens on 127.0.0.1:local_port and sends to 127.0.0.1:remote_port.
+    // Returns false if the port is taken (or there are no sockets here).
+    bool Open(uint16_t local_port, uint16_t remote_port, NetConditions net) {
+#if defined(__unix__) || defined(__APPLE__)
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            return false;
+        }
+
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(local_port);
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0) {
+            close(fd);
+            fd = -1;
+            return false;
+        }
+
+        peer_port = remote_port;
+        conditions = net;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Queues a packet for the peer; it goes out once the simulated delay is over
+    void Send(const std::vector<unsigned char>& data) {
+        sent++;
+        if (conditions.loss > 0.0f && std::uniform_real_distribution<float>(0.0f, 1.0f)(random) < conditions.loss) {
+            dropped++;
+            return;
+        }
+
+        if (conditions.delay_ms <= 0.0f) {
+            SendNow(data);
+            return;
+        }
+
+        auto delay = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(conditions.delay_ms));
+        outgoing.push_back({Clock::now() + delay, data});
+    }
+
+    // Sends the delayed packets that are due. Call regularly (every frame).
+    void Flush() {
+        Clock::time_point now = Clock::now();
+        while (!outgoing.empty() && outgoing.front().due <= now) {
+            SendNow(outgoing.front().data);
+            outgoing.pop_front();
+        }
+    }
+
+    // Sends every packet still held back right away, due or not (for when the game is closing)
+    void FlushAll() {
+        while (!outgoing.empty()) {
+            SendNow(outgoing.front().data);
+            outgoing.pop_front();
+        }
+    }
+
+    // Reads the next packet that arrived into data. Returns false when there are none left.
+    bool Receive(std::vector<unsigned char>& data) {
+#if defined(__unix__) || defined(__APPLE__)
+        if (fd < 0) {
+            return false;
+        }
+
+        data.resize(65536);
+        ssize_t size = recv(fd, data.data(), data.size(), 0);
+        if (size < 0) {
+            data.clear();
+            return false;
+        }
+
+        data.resize(size_t(size));
+        received++;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    size_t GetSentCount() const {
+        return sent;
+    }
+
+    size_t GetDroppedCount() const {
+        return dropped;
+    }
+
+    size_t GetReceivedCount() const {
+        return received;
+    }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef WORLD_SNAPSHOT
+#define WORLD_SNAPSHOT
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "binary_file.hpp"
+#include "components.hpp"
+#include "entt.hpp"
+#include "game_registry.hpp"
+
+// Saving and restoring the whole world (every entity and component) with
+// entt::snapshot / entt::snapshot_loader.
+// Components are trivially copyable, so the archives below just memcpy them
+// into (and out of) one contiguous byte buffer.
+
+// Output archive for entt::snapshot, appending raw bytes to a buffer
+class SnapshotOutputArchive {
+    std::vector<unsigned char>& buffer;
+
+    template<typename Type>
+    void Write(const Type& value) {
+        static_assert(std::is_trivially_copyable_v<Type>, "Snapshot values must be trivially copyable");
+
+        size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(Type));
+        memcpy(buffer.data() + offset, &value, sizeof(Type));
+    }
+
+public:
+    explicit SnapshotOutputArchive(std::vector<unsigned char>& buffer) : buffer(buffer) {}
+
+    template<typename... Type>
+    void operator()(const Type&... values) {
+        (Write(values), ...);
+    }
+};
+
+// Input archive for entt::snapshot_loader, reading back what SnapshotOutputArchive wrote
+class SnapshotInputArchive {
+    const std::vector<unsigned char>& buffer;
+    size_t offset = 0;
+    bool failed = false;
+
+    template<typename Type>
+    void Read(Type& value) {
+        if (offset + sizeof(Type) > buffer.size()) {
+            // Truncated data: keep going with zeroes so the loader terminates
+            value = Type{};
+            failed = true;
+            return;
+        }
+
+        memcpy(&value, buffer.data() + offset, sizeof(Type));
+        offset += sizeof(Type);
+    }
+
+public:
+    explicit SnapshotInputArchive(const std::vector<unsigned char>& buffer) : buffer(buffer) {}
+
+    template<typename... Type>
+    void operator()(Type&... values) {
+        (Read(values), ...);
+    }
+
+    bool Failed() const {
+        return failed;
+    }
+};
+
+// Every component that is part of the world state.
+// Add new components here so they're saved and restored too.
+template<typename Snapshot, typename Archive>
+void ArchiveComponents(const Snapshot& snapshot, Archive& archive) {
+    snapshot.template component<PositionComponent, SizeComponent, ColorComponent,
+                                VelocityComponent, CircleColliderComponent, ForceComponent, PointComponent,
+                                SlingComponent, AnimationComponent, ContactComponent, PlayerComponent>(archive);
+}
+
+// A saved copy of the world
+struct WorldSnapshot {
+    std::vector<unsigned char> data;
+};
+
+// Saves every entity and component of the registry into the snapshot.
+// The snapshot's buffer is reused, so saving repeatedly doesn't allocate.
+inline void SaveWorld(const GameRegistry& registry, WorldSnapshot& snapshot) {
+    snapshot.data.clear();
+
+    SnapshotOutputArchive archive(snapshot.data);
+    ArchiveComponents(entt::basic_snapshot{registry}.entities(archive), archive);
+}
+
+// Replaces everything in the registry with the contents of the snapshot.
+// Entities keep the identifiers they had when saved, so stored entt::entity
+// values stay valid. The component storages themselves are kept, so views
+// made before the load can still be used; component references can't.
+// Returns false if the snapshot was incomplete.
+inline bool LoadWorld(GameRegistry& registry, const WorldSnapshot& snapshot) {
+    registry.clear();
+
+    SnapshotInputArchive archive(snapshot.data);
+    ArchiveComponents(entt::basic_snapshot_loader{registry}.entities(archive), archive);
+
+    return !archive.Failed();
+}
+
+// File format for saved snapshots: a small header followed by the snapshot bytes
+const char WORLD_SNAPSHOT_MAGIC[4] = {'S', 'I', 'O', 'S'};
+const uint32_t WORLD_SNAPSHOT_VERSION = 3;
+
+struct WorldSnapshotFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t size;
+};
+
+// Writes the snapshot to a file. Returns false if it couldn't be written.
+inline bool SaveWorldToFile(const WorldSnapshot& snapshot, const std::string& path) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    WorldSnapshotFileHeader header;
+    memcpy(header.magic, WORLD_SNAPSHOT_MAGIC, sizeof(WORLD_SNAPSHOT_MAGIC));
+    header.version = WORLD_SNAPSHOT_VERSION;
+    header.size = snapshot.data.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(snapshot.data.data(), 1, snapshot.data.size(), file) == snapshot.data.size();
+
+    return fclose(file) == 0 && ok;
+}
+
+// Reads a snapshot written by SaveWorldToFile. Returns false if it's missing or invalid.
+inline bool LoadWorldFromFile(WorldSnapshot& snapshot, const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    WorldSnapshotFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, WORLD_SNAPSHOT_MAGIC, sizeof(WORLD_SNAPSHOT_MAGIC)) == 0 &&
+              header.version == WORLD_SNAPSHOT_VERSION &&
+              HasBytesLeft(file, header.size);
+
+    if (ok) {
+        snapshot.data.resize(size_t(header.size));
+        ok = fread(snapshot.data.data(), 1, snapshot.data.size(), file) == snapshot.data.size();
+    }
+
+    fclose(file);
+    return ok;
+}
+
+#endif